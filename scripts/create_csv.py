@@ -2,8 +2,11 @@
 # pylint: disable=C0111
 import argparse
 import datetime
+import math
 import multiprocessing
+import statistics
 import subprocess
+import sys
 import time
 
 import cpuinfo
@@ -32,6 +35,17 @@ if AVX256_ENABLE:
 if AVX512_ENABLE:
     ALL_ALGS += ",avx512,avx512_unroll,avx512_blocking,avx512_parallel"
 
+DEFAULT_REPEAT = 5
+DEFAULT_TOLERANCE = 0.05
+BASELINE_NAME = "./out/dgemm_baseline"
+
+# t de Student bicaudal 95% para 1 a 30 graus de liberdade
+T_95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+        2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+        2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+        2.048, 2.045, 2.042]
+Z_95 = 1.960
+
 RANGE_ROUNDS = 5
 MAX_ROUNDS = 3
 MIN_DIFF = 1
@@ -52,8 +66,14 @@ def log(message, level=DEBUG_MESSAGE):
 
 def criar_build(name, unroll, block_size):
     command = ["gcc", "-O3", "-fopenmp", "-march=native", "src/main.c",
-               "src/dgemm.c", "-o", name, "-DUNROLL="+str(unroll),
-               "-DBLOCK_SIZE="+str(block_size), "-lm"]
+               "src/dgemm.c", "src/multiply.c", "src/sparse.c",
+               "src/server.c", "src/client.c", "src/chain.c", "src/summa.c",
+               "src/affinity.c", "src/generator.c",
+               "src/energy.c", "src/trace.c", "src/packed.c",
+               "src/topology.c", "src/level2.c", "src/incremental.c",
+               "-o", name,
+               "-DUNROLL="+str(unroll), "-DBLOCK_SIZE="+str(block_size),
+               "-lm"]
 
     subprocess.run(command, check=True)
 
@@ -283,6 +303,112 @@ def rodar_todas_dgemm(algs, unroll, block_size, loop, num_process, filename):
         file.write(saida)
 
 
+def ler_baseline(filename):
+    baseline = {}
+
+    with open(filename, encoding="utf-8") as file:
+        for line in file:
+            columns = line.strip().split(",")
+            if len(columns) < 4:
+                continue
+
+            alg_size = int(columns[1])
+            baseline.setdefault(columns[0], {})[alg_size] = float(columns[3])
+
+    return baseline
+
+
+def intervalo_confianca(samples):
+    mean = statistics.mean(samples)
+
+    if len(samples) < 2:
+        return mean, mean, mean
+
+    degrees = len(samples) - 1
+    t = T_95[degrees - 1] if degrees <= len(T_95) else Z_95
+    margin = t * statistics.stdev(samples) / math.sqrt(len(samples))
+
+    return mean, mean - margin, mean + margin
+
+
+def rodar_repeticoes(name, algs, sizes, repeat):
+    samples = {}
+
+    for i in range(repeat):
+        log(f"inicializando repetição {i}", STATUS_MESSAGE)
+
+        for size in sizes:
+            command = [name, "-d", algs, "-l", str(size), "-p"]
+
+            result = subprocess.run(
+                command, capture_output=True, text=True, check=True)
+
+            for line in result.stdout.splitlines():
+                columns = line.strip().split(",")
+                samples.setdefault(columns[0], {})\
+                    .setdefault(int(columns[1]), [])\
+                    .append(float(columns[3]))
+
+    return samples
+
+
+def comparar_baseline(filename, unroll, block_size, repeat, tolerance,
+                      dgemms):
+    baseline = ler_baseline(filename)
+    available = ALL_ALGS.split(",")
+    algs = [alg for alg in baseline
+            if alg in available and (not dgemms or alg in dgemms)]
+    sizes = sorted({size for alg in algs for size in baseline[alg]})
+
+    log(f"Comparando {len(algs)} algoritmos e {len(sizes)} tamanhos com "
+        f"{filename}", INFO_MESSAGE)
+
+    criar_build(BASELINE_NAME, unroll, block_size)
+    samples = rodar_repeticoes(BASELINE_NAME, ",".join(algs), sizes, repeat)
+
+    regressions = 0
+    saida = "algoritmo,pontos,speedup_geometrico,speedup_minimo," \
+        "tamanho_minimo,regressoes,melhorias\n"
+
+    for alg in algs:
+        speedups = []
+        worst = (math.inf, 0)
+        slower = 0
+        faster = 0
+
+        for size, reference in sorted(baseline[alg].items()):
+            current = samples.get(alg, {}).get(size)
+            if not current or reference <= 0:
+                continue
+
+            mean, low, high = intervalo_confianca(current)
+            speedup = mean / reference
+            speedups.append(speedup)
+            worst = min(worst, (speedup, size))
+
+            if high < reference * (1 - tolerance):
+                slower += 1
+                log(f"regressão em {alg} com N={size}: {mean:.2f} GFLOPS "
+                    f"(IC95 {low:.2f} a {high:.2f}) contra {reference:.2f}",
+                    INFO_MESSAGE)
+            elif low > reference * (1 + tolerance):
+                faster += 1
+
+        if not speedups:
+            continue
+
+        geometric = math.exp(
+            sum(math.log(max(speedup, 1e-9)) for speedup in speedups)
+            / len(speedups))
+        saida += f"{alg},{len(speedups)},{geometric:.3f},{worst[0]:.3f}," \
+            f"{worst[1]},{slower},{faster}\n"
+        regressions += slower
+
+    print(saida, end="")
+
+    return regressions
+
+
 class CustomHelpFormatter(argparse.HelpFormatter):
     def add_argument(self, action):
         if action.option_strings == ["-h", "--help"]:
@@ -312,12 +438,32 @@ def main():
                         help="Especifica nível do log")
     parser.add_argument("-P", "--only-parallel", type=bool, default=False,
                         help="Rodar somente agoritmos com otimização de paralelismos")
+    parser.add_argument("-B", "--baseline", type=str,
+                        help="Compara com um csv salvo e retorna erro se houver regressão")
+    parser.add_argument("-r", "--repeat", default=DEFAULT_REPEAT, type=int,
+                        help="Repetições de cada ponto na comparação")
+    parser.add_argument("-t", "--tolerance", default=DEFAULT_TOLERANCE,
+                        type=float,
+                        help="Queda mínima para contar como regressão")
+    parser.add_argument("-d", "--dgemm", type=str,
+                        help="Algoritmos usados na comparação")
 
     arguments = parser.parse_args()
 
     global MAX_LOG_LEVEL
     MAX_LOG_LEVEL = arguments.log
 
+    if arguments.baseline:
+        regressions = comparar_baseline(
+            arguments.baseline,
+            arguments.unroll or DEFAULT_UNROLL,
+            arguments.block_size or DEFAULT_BLOCK_SIZE,
+            arguments.repeat,
+            arguments.tolerance,
+            arguments.dgemm.split(",") if arguments.dgemm else None
+        )
+        sys.exit(1 if regressions > 0 else 0)
+
     if arguments.unroll:
         unroll = arguments.unroll
     else:
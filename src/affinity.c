@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include "affinity.h"
+#include <omp.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int parse_cpu_list(const char *list, cpu_list *cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  const char *cursor = list;
+
+  while (*cursor != '\0') {
+    int first, last, read;
+
+    if (sscanf(cursor, "%d%n", &first, &read) != 1)
+      return -1;
+
+    cursor += read;
+    last = first;
+
+    if (*cursor == '-') {
+      if (sscanf(++cursor, "%d%n", &last, &read) != 1)
+        return -1;
+
+      cursor += read;
+    }
+
+    if (first < 0 || last < first || last >= CPU_SETSIZE)
+      return -1;
+
+    for (int cpu = first; cpu <= last; cpu++)
+      CPU_SET(cpu, &set);
+
+    if (*cursor == ',')
+      cursor++;
+    else if (*cursor != '\0')
+      return -1;
+  }
+
+  cpus->count = 0;
+  cpus->cpus = malloc(CPU_COUNT(&set) * sizeof(int));
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    if (CPU_ISSET(cpu, &set))
+      cpus->cpus[cpus->count++] = cpu;
+
+  return cpus->count > 0 ? 0 : -1;
+}
+
+int allowed_cpu_list(cpu_list *cpus) {
+  cpu_set_t set;
+
+  if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    return -1;
+
+  cpus->count = 0;
+  cpus->cpus = malloc(CPU_COUNT(&set) * sizeof(int));
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    if (CPU_ISSET(cpu, &set))
+      cpus->cpus[cpus->count++] = cpu;
+
+  return 0;
+}
+
+int pin_thread(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return sched_setaffinity(0, sizeof(set), &set);
+}
+
+void pin_omp_threads(cpu_list *cpus, int threads) {
+#pragma omp parallel num_threads(threads)
+  pin_thread(cpus->cpus[omp_get_thread_num() % cpus->count]);
+}
+
+int restore_thread(cpu_list *cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  for (int i = 0; i < cpus->count; i++)
+    CPU_SET(cpus->cpus[i], &set);
+
+  return sched_setaffinity(0, sizeof(set), &set);
+}
+
+void restore_omp_threads(cpu_list *cpus, int threads) {
+#pragma omp parallel num_threads(threads)
+  restore_thread(cpus);
+}
+
+void free_cpu_list(cpu_list *cpus) {
+  free(cpus->cpus);
+  cpus->cpus = NULL;
+  cpus->count = 0;
+}
@@ -0,0 +1,17 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+typedef struct {
+  int count;
+  int *cpus;
+} cpu_list;
+
+int parse_cpu_list(const char *list, cpu_list *cpus);
+int allowed_cpu_list(cpu_list *cpus);
+int pin_thread(int cpu);
+void pin_omp_threads(cpu_list *cpus, int threads);
+int restore_thread(cpu_list *cpus);
+void restore_omp_threads(cpu_list *cpus, int threads);
+void free_cpu_list(cpu_list *cpus);
+
+#endif
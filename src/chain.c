@@ -0,0 +1,239 @@
+#include "chain.h"
+#include "dgemm.h"
+#include "generator.h"
+#include "level2.h"
+#include <float.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  chain_plan *plan;
+  double **matrices;
+  bool execute;
+  bool *in_use;
+  size_t *size;
+  double **buffer;
+} chain_run;
+
+void calibrate_chain(chain_calibration *calibration) {
+  generator generator = {0, distribution_uniform};
+
+  for (int s = 0; s < CHAIN_CALIBRATION_SIZES; s++) {
+    int length = 8 << s;
+    double *a = aligned_alloc(ALIGN, length * length * sizeof(double));
+    double *b = aligned_alloc(ALIGN, length * length * sizeof(double));
+    double *c = aligned_alloc(ALIGN, length * length * sizeof(double));
+
+    generate_matrix(&generator, stream_a, length, length, a);
+    generate_matrix(&generator, stream_b, length, length, b);
+    memset(c, 0, length * length * sizeof(double));
+
+    int runs = 0;
+    double start_time = omp_get_wtime(), diff;
+    do {
+      dgemm_rectangular(length, length, length, a, length, b, length, c,
+                        length);
+      runs++;
+      diff = omp_get_wtime() - start_time;
+    } while (diff < 0.02);
+
+    calibration->size[s] = length;
+    calibration->gflops[s] = 2.0 * length * length * length * runs / diff / 1e9;
+
+    free(a);
+    free(b);
+    free(c);
+  }
+}
+
+double product_cost(chain_calibration *calibration, int m, int n, int k) {
+  double flops = 2.0 * m * n * k;
+
+  if (calibration == NULL)
+    return flops;
+
+  int smallest = m < n ? (m < k ? m : k) : (n < k ? n : k);
+  double gflops = calibration->gflops[0];
+
+  for (int s = 0; s < CHAIN_CALIBRATION_SIZES; s++)
+    if (calibration->size[s] <= smallest)
+      gflops = calibration->gflops[s];
+
+  return flops / (gflops * 1e9);
+}
+
+chain_plan *alloc_chain_plan(int count, int *dims) {
+  chain_plan *plan = malloc(sizeof(chain_plan));
+  plan->count = count;
+  plan->dims = malloc((count + 1) * sizeof(int));
+  plan->split = malloc(count * count * sizeof(int));
+  plan->cost = malloc(count * count * sizeof(double));
+
+  memcpy(plan->dims, dims, (count + 1) * sizeof(int));
+
+  for (int i = 0; i < count; i++)
+    plan->cost[i + i * count] = 0;
+
+  return plan;
+}
+
+chain_plan *plan_chain(int count, int *dims, chain_calibration *calibration) {
+  chain_plan *plan = alloc_chain_plan(count, dims);
+
+  for (int width = 1; width < count; width++) {
+    for (int i = 0; i + width < count; i++) {
+      int j = i + width;
+      double best = DBL_MAX;
+
+      for (int s = i; s < j; s++) {
+        double cost = plan->cost[i + s * count] +
+                      plan->cost[s + 1 + j * count] +
+                      product_cost(calibration, dims[i], dims[j + 1],
+                                   dims[s + 1]);
+
+        if (cost < best) {
+          best = cost;
+          plan->split[i + j * count] = s;
+        }
+      }
+
+      plan->cost[i + j * count] = best;
+    }
+  }
+
+  return plan;
+}
+
+chain_plan *plan_chain_naive(int count, int *dims) {
+  chain_plan *plan = alloc_chain_plan(count, dims);
+
+  for (int j = 1; j < count; j++) {
+    for (int i = 0; i < j; i++) {
+      plan->split[i + j * count] = j - 1;
+      plan->cost[i + j * count] = plan->cost[i + (j - 1) * count] +
+                                  product_cost(NULL, dims[i], dims[j + 1],
+                                               dims[j]);
+    }
+  }
+
+  return plan;
+}
+
+double chain_node_flops(chain_plan *plan, int i, int j) {
+  if (i == j)
+    return 0;
+
+  int s = plan->split[i + j * plan->count];
+
+  return chain_node_flops(plan, i, s) + chain_node_flops(plan, s + 1, j) +
+         2.0 * plan->dims[i] * plan->dims[s + 1] * plan->dims[j + 1];
+}
+
+double chain_flops(chain_plan *plan) {
+  return chain_node_flops(plan, 0, plan->count - 1);
+}
+
+char *write_parenthesization(chain_plan *plan, int i, int j, char *buffer) {
+  if (i == j)
+    return buffer + sprintf(buffer, "A%d", i + 1);
+
+  int s = plan->split[i + j * plan->count];
+
+  *buffer++ = '(';
+  buffer = write_parenthesization(plan, i, s, buffer);
+  buffer = write_parenthesization(plan, s + 1, j, buffer);
+  *buffer++ = ')';
+  *buffer = '\0';
+
+  return buffer;
+}
+
+void chain_parenthesization(chain_plan *plan, char *buffer) {
+  write_parenthesization(plan, 0, plan->count - 1, buffer);
+}
+
+int acquire_slot(chain_run *run, size_t size) {
+  int slot = 0;
+
+  while (run->in_use[slot])
+    slot++;
+
+  run->in_use[slot] = true;
+
+  if (run->size[slot] < size)
+    run->size[slot] = size;
+
+  return slot;
+}
+
+double *evaluate_chain(chain_run *run, int i, int j, double *output,
+                       int *slot) {
+  *slot = -1;
+
+  if (i == j)
+    return run->matrices[i];
+
+  chain_plan *plan = run->plan;
+  int s = plan->split[i + j * plan->count];
+  int m = plan->dims[i], n = plan->dims[j + 1], k = plan->dims[s + 1];
+  int left_slot, right_slot;
+
+  double *left = evaluate_chain(run, i, s, NULL, &left_slot);
+  double *right = evaluate_chain(run, s + 1, j, NULL, &right_slot);
+
+  if (output == NULL) {
+    *slot = acquire_slot(run, (size_t)m * n);
+    output = run->buffer[*slot];
+  }
+
+  if (run->execute) {
+    memset(output, 0, (size_t)m * n * sizeof(double));
+    dgemm_dispatch(m, n, k, left, m, right, k, output, m);
+  }
+
+  if (left_slot >= 0)
+    run->in_use[left_slot] = false;
+
+  if (right_slot >= 0)
+    run->in_use[right_slot] = false;
+
+  return output;
+}
+
+void chain_multiply(chain_plan *plan, double **matrices, double *result) {
+  int count = plan->count;
+  int slot;
+  chain_run run = {plan, matrices, false, calloc(count, sizeof(bool)),
+                   calloc(count, sizeof(size_t)),
+                   calloc(count, sizeof(double *))};
+
+  evaluate_chain(&run, 0, count - 1, result, &slot);
+
+  for (int s = 0; s < count; s++) {
+    run.in_use[s] = false;
+
+    if (run.size[s] > 0) {
+      size_t size = run.size[s] * sizeof(double);
+      run.buffer[s] = aligned_alloc(ALIGN, (size + ALIGN - 1) / ALIGN * ALIGN);
+    }
+  }
+
+  run.execute = true;
+  evaluate_chain(&run, 0, count - 1, result, &slot);
+
+  for (int s = 0; s < count; s++)
+    free(run.buffer[s]);
+
+  free(run.in_use);
+  free(run.size);
+  free(run.buffer);
+}
+
+void free_chain_plan(chain_plan *plan) {
+  free(plan->dims);
+  free(plan->split);
+  free(plan->cost);
+  free(plan);
+}
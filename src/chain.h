@@ -0,0 +1,28 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <stdbool.h>
+
+#define CHAIN_CALIBRATION_SIZES 7
+
+typedef struct {
+  int size[CHAIN_CALIBRATION_SIZES];
+  double gflops[CHAIN_CALIBRATION_SIZES];
+} chain_calibration;
+
+typedef struct {
+  int count;
+  int *dims;
+  int *split;
+  double *cost;
+} chain_plan;
+
+void calibrate_chain(chain_calibration *calibration);
+chain_plan *plan_chain(int count, int *dims, chain_calibration *calibration);
+chain_plan *plan_chain_naive(int count, int *dims);
+double chain_flops(chain_plan *plan);
+void chain_parenthesization(chain_plan *plan, char *buffer);
+void chain_multiply(chain_plan *plan, double **matrices, double *result);
+void free_chain_plan(chain_plan *plan);
+
+#endif
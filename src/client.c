@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include "client.h"
+#include "dgemm.h"
+#include "server.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+size_t matrix_stride(int length) {
+  size_t size = (size_t)length * length * sizeof(double);
+  return (size + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+int send_request(dgemm_client *client, server_request *request, int fd,
+                 server_response *response) {
+  char control[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {request, sizeof(server_request)};
+  struct msghdr message = {0};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  errno = 0;
+
+  if (fd >= 0) {
+    memset(control, 0, sizeof(control));
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &fd, sizeof(int));
+  }
+
+  if (sendmsg(client->socket, &message, MSG_NOSIGNAL) !=
+      sizeof(server_request))
+    return errno ? errno : EIO;
+
+  if (recv(client->socket, response, sizeof(server_response), MSG_WAITALL) !=
+      sizeof(server_response))
+    return errno ? errno : EIO;
+
+  return response->status;
+}
+
+int dgemm_client_connect(dgemm_client *client, const char *path, int length) {
+  struct sockaddr_un address = {0};
+  address.sun_family = AF_UNIX;
+
+  if (strlen(path) >= sizeof(address.sun_path))
+    return ENAMETOOLONG;
+
+  strcpy(address.sun_path, path);
+
+  client->length = length;
+  client->size = 3 * matrix_stride(length);
+  client->memory = NULL;
+  client->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (client->socket < 0)
+    return errno;
+
+  if (connect(client->socket, (struct sockaddr *)&address, sizeof(address)) <
+      0) {
+    int error = errno;
+    close(client->socket);
+    return error;
+  }
+
+  int fd = memfd_create("dgemm", MFD_CLOEXEC);
+  if (fd < 0 || ftruncate(fd, client->size) < 0) {
+    int error = errno;
+    if (fd >= 0)
+      close(fd);
+    close(client->socket);
+    return error;
+  }
+
+  client->memory = mmap(NULL, client->size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+  if (client->memory == MAP_FAILED) {
+    int error = errno;
+    close(fd);
+    close(client->socket);
+    client->memory = NULL;
+    return error;
+  }
+
+  server_request request = {0};
+  server_response response = {0, 0};
+  request.type = request_map;
+  request.size = client->size;
+
+  int status = send_request(client, &request, fd, &response);
+  close(fd);
+
+  if (status != 0)
+    dgemm_client_close(client);
+
+  return status;
+}
+
+double *dgemm_client_matrix(dgemm_client *client, int index) {
+  return (double *)((char *)client->memory +
+                    index * matrix_stride(client->length));
+}
+
+int dgemm_client_multiply(dgemm_client *client, int dgemm, double *a,
+                          double *b, double *c, bool clean, double *seconds) {
+  char *memory = (char *)client->memory;
+  server_request request = {0};
+  server_response response = {0, 0};
+
+  request.type = request_multiply;
+  request.dgemm = dgemm;
+  request.length = client->length;
+  request.clean = clean;
+  request.a = (char *)a - memory;
+  request.b = (char *)b - memory;
+  request.c = (char *)c - memory;
+
+  int status = send_request(client, &request, -1, &response);
+
+  if (seconds != NULL)
+    *seconds = response.seconds;
+
+  return status;
+}
+
+void dgemm_client_close(dgemm_client *client) {
+  if (client->memory != NULL)
+    munmap(client->memory, client->size);
+
+  close(client->socket);
+  client->memory = NULL;
+  client->socket = -1;
+}
@@ -0,0 +1,20 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+  int socket;
+  int length;
+  size_t size;
+  double *memory;
+} dgemm_client;
+
+int dgemm_client_connect(dgemm_client *client, const char *path, int length);
+double *dgemm_client_matrix(dgemm_client *client, int index);
+int dgemm_client_multiply(dgemm_client *client, int dgemm, double *a,
+                          double *b, double *c, bool clean, double *seconds);
+void dgemm_client_close(dgemm_client *client);
+
+#endif
@@ -1,9 +1,29 @@
 #include "dgemm.h"
+#include "trace.h"
+#ifdef USE_CBLAS
+#include <cblas.h>
+#endif
 #include <omp.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <x86intrin.h>
 
+int dgemm_thread_count = 0;
+
+void set_dgemm_threads(int threads) {
+  dgemm_thread_count = threads;
+#ifdef USE_CBLAS
+  openblas_set_num_threads(threads > 0 ? threads : omp_get_num_procs());
+#endif
+}
+
+int dgemm_threads(int length) {
+  return dgemm_thread_count > 0 ? dgemm_thread_count : length / BLOCK_SIZE;
+}
+
 void copy_transpose(int length, double *matrix, double *transpose) {
   for (int i = 0; i < length; i++)
     for (int j = 0; j < length; j++)
@@ -50,11 +70,14 @@ void dgemm_simple_unroll_blocking(int length, double *a, double *b, double *c) {
 
 void dgemm_simple_unroll_blocking_parallel(int length, double *a, double *b,
                                            double *c) {
-#pragma omp parallel for num_threads(length / BLOCK_SIZE)
+#pragma omp parallel for num_threads(dgemm_threads(length))
   for (int sj = 0; sj < length; sj += BLOCK_SIZE)
     for (int si = 0; si < length; si += BLOCK_SIZE)
-      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
         block_simple_unroll(length, si, sj, sk, a, b, c);
+        TRACE_END("simple_parallel", si, sj, sk);
+      }
 }
 
 void dgemm_transpose(int length, double *a, double *b, double *c) {
@@ -114,13 +137,18 @@ void dgemm_transpose_unroll_blocking(int length, double *a, double *b,
 void dgemm_transpose_unroll_blocking_parallel(int length, double *a, double *b,
                                               double *c) {
   double *at = aligned_alloc(ALIGN, length * length * sizeof(double));
+  TRACE_BEGIN();
   copy_transpose(length, a, at);
+  TRACE_END("pack", 0, 0, 0);
 
-#pragma omp parallel for num_threads(length / BLOCK_SIZE)
+#pragma omp parallel for num_threads(dgemm_threads(length))
   for (int si = 0; si < length; si += BLOCK_SIZE)
     for (int sj = 0; sj < length; sj += BLOCK_SIZE)
-      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
         block_transpose_unroll(length, si, sj, sk, at, b, c);
+        TRACE_END("transpose_parallel", si, sj, sk);
+      }
 
   free(at);
 }
@@ -216,13 +244,18 @@ void dgemm_simd_manual_unroll_blocking(int length, double *a, double *b,
 void dgemm_simd_manual_unroll_blocking_parallel(int length, double *a,
                                                 double *b, double *c) {
   double *at = aligned_alloc(ALIGN, length * length * sizeof(double));
+  TRACE_BEGIN();
   copy_transpose(length, a, at);
+  TRACE_END("pack", 0, 0, 0);
 
-#pragma omp parallel for num_threads(length / BLOCK_SIZE)
+#pragma omp parallel for num_threads(dgemm_threads(length))
   for (int si = 0; si < length; si += BLOCK_SIZE)
     for (int sj = 0; sj < length; sj += BLOCK_SIZE)
-      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
         block_simd_manual_unroll(length, si, sj, sk, at, b, c);
+        TRACE_END("simd_manual_parallel", si, sj, sk);
+      }
 
   free(at);
 }
@@ -288,19 +321,54 @@ void dgemm_avx256_unroll(int length, double *a, double *b, double *c) {
 #endif
 }
 
+#if __AVX__ || __AVX2__
+__m256d epilogue_load(double *c, int sk, dgemm_epilogue *epilogue) {
+  if (epilogue == NULL || sk > 0)
+    return _mm256_load_pd(c);
+
+  if (epilogue->beta == 0)
+    return _mm256_setzero_pd();
+
+  return _mm256_mul_pd(_mm256_load_pd(c), _mm256_set1_pd(epilogue->beta));
+}
+
+void epilogue_store(double *c, __m256d acc, int i, int sk, int length,
+                    dgemm_epilogue *epilogue) {
+  if (epilogue != NULL && sk + BLOCK_SIZE == length) {
+    if (epilogue->bias != NULL)
+      acc = _mm256_add_pd(acc, _mm256_loadu_pd(epilogue->bias + i));
+
+    if (epilogue->activation == activation_relu) {
+      acc = _mm256_max_pd(acc, _mm256_setzero_pd());
+    } else if (epilogue->activation == activation_clamp) {
+      acc = _mm256_max_pd(acc, _mm256_set1_pd(epilogue->min));
+      acc = _mm256_min_pd(acc, _mm256_set1_pd(epilogue->max));
+    }
+  }
+
+  _mm256_store_pd(c, acc);
+}
+#endif
+
 void block_avx256_unroll(int length, int si, int sj, int sk, double *a,
-                         double *b, double *c) {
+                         double *b, double *c, dgemm_epilogue *epilogue) {
 #if __AVX__ || __AVX2__
+  __m256d alpha = _mm256_set1_pd(epilogue != NULL ? epilogue->alpha : 1);
+
   for (int i = si; i < si + BLOCK_SIZE; i += UNROLL * AVX256_QT_DOUBLE) {
     for (int j = sj; j < sj + BLOCK_SIZE; j++) {
       __m256d acc[UNROLL];
 
       for (int r = 0; r < UNROLL; r++)
-        acc[r] = _mm256_load_pd(c + i + j * length + r * AVX256_QT_DOUBLE);
+        acc[r] = epilogue_load(c + i + j * length + r * AVX256_QT_DOUBLE, sk,
+                               epilogue);
 
       for (int k = sk; k < sk + BLOCK_SIZE; k++) {
         __m256d column = _mm256_broadcast_sd(b + k + j * length);
 
+        if (epilogue != NULL)
+          column = _mm256_mul_pd(column, alpha);
+
         for (int r = 0; r < UNROLL; r++) {
           __m256d row =
               _mm256_load_pd(a + i + k * length + r * AVX256_QT_DOUBLE);
@@ -310,7 +378,8 @@ void block_avx256_unroll(int length, int si, int sj, int sk, double *a,
       }
 
       for (int r = 0; r < UNROLL; r++)
-        _mm256_store_pd(c + i + j * length + r * AVX256_QT_DOUBLE, acc[r]);
+        epilogue_store(c + i + j * length + r * AVX256_QT_DOUBLE, acc[r],
+                       i + r * AVX256_QT_DOUBLE, sk, length, epilogue);
     }
   }
 #endif
@@ -320,27 +389,55 @@ void dgemm_avx256_unroll_blocking(int length, double *a, double *b, double *c) {
   for (int si = 0; si < length; si += BLOCK_SIZE)
     for (int sj = 0; sj < length; sj += BLOCK_SIZE)
       for (int sk = 0; sk < length; sk += BLOCK_SIZE)
-        block_avx256_unroll(length, si, sj, sk, a, b, c);
+        block_avx256_unroll(length, si, sj, sk, a, b, c, NULL);
+}
+
+void dgemm_avx256_unroll_blocking_epilogue(int length, double *a, double *b,
+                                           double *c,
+                                           dgemm_epilogue *epilogue) {
+  for (int si = 0; si < length; si += BLOCK_SIZE)
+    for (int sj = 0; sj < length; sj += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
+        block_avx256_unroll(length, si, sj, sk, a, b, c, epilogue);
 }
 
 void dgemm_avx256_unroll_blocking_parallel(int length, double *a, double *b,
                                            double *c) {
-#pragma omp parallel for num_threads(length / BLOCK_SIZE)
+#pragma omp parallel for num_threads(dgemm_threads(length))
   for (int si = 0; si < length; si += BLOCK_SIZE)
     for (int sj = 0; sj < length; sj += BLOCK_SIZE)
-      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
-        block_avx256_unroll(length, si, sj, sk, a, b, c);
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_avx256_unroll(length, si, sj, sk, a, b, c, NULL);
+        TRACE_END("avx256_parallel", si, sj, sk);
+      }
+}
+
+void dgemm_avx256_unroll_blocking_parallel_epilogue(int length, double *a,
+                                                    double *b, double *c,
+                                                    dgemm_epilogue *epilogue) {
+#pragma omp parallel for num_threads(dgemm_threads(length))
+  for (int si = 0; si < length; si += BLOCK_SIZE)
+    for (int sj = 0; sj < length; sj += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_avx256_unroll(length, si, sj, sk, a, b, c, epilogue);
+        TRACE_END("avx256_parallel", si, sj, sk);
+      }
 }
 
 void block_perfect(int length, int si, int sj, int sk, double *a, double *b,
-                   double *c) {
+                   double *c, dgemm_epilogue *epilogue) {
 #if __AVX__ || __AVX2__
+  __m256d alpha = _mm256_set1_pd(epilogue != NULL ? epilogue->alpha : 1);
+
   for (int i = si; i < si + BLOCK_SIZE; i += UNROLL * AVX256_QT_DOUBLE) {
     for (int j = sj; j < sj + BLOCK_SIZE; j++) {
       __m256d acc[UNROLL];
 
       for (int r = 0; r < UNROLL; r++)
-        acc[r] = _mm256_load_pd(c + i + j * length + 0*4 + r * AVX256_QT_DOUBLE);
+        acc[r] = epilogue_load(c + i + j * length + r * AVX256_QT_DOUBLE, sk,
+                               epilogue);
 
       for (int k = sk; k < sk + BLOCK_SIZE; k+=4) {
         __m256d column[4];
@@ -349,6 +446,13 @@ void block_perfect(int length, int si, int sj, int sk, double *a, double *b,
         column[2] = _mm256_broadcast_sd(b + k + 2 + j * length);
         column[3] = _mm256_broadcast_sd(b + k + 3 + j * length);
 
+        if (epilogue != NULL) {
+          column[0] = _mm256_mul_pd(column[0], alpha);
+          column[1] = _mm256_mul_pd(column[1], alpha);
+          column[2] = _mm256_mul_pd(column[2], alpha);
+          column[3] = _mm256_mul_pd(column[3], alpha);
+        }
+
         for (int r = 0; r < UNROLL; r++) {
           __m256d row0 =
               _mm256_load_pd(a + i + (k + 0) * length + r * AVX256_QT_DOUBLE);
@@ -372,18 +476,34 @@ void block_perfect(int length, int si, int sj, int sk, double *a, double *b,
       }
 
       for (int r = 0; r < UNROLL; r++)
-        _mm256_store_pd(c + i + j * length + r * AVX256_QT_DOUBLE, acc[r]);
+        epilogue_store(c + i + j * length + r * AVX256_QT_DOUBLE, acc[r],
+                       i + r * AVX256_QT_DOUBLE, sk, length, epilogue);
     }
   }
 #endif
 }
 
 void dgemm_perfect(int length, double *a, double *b, double *c) {
-#pragma omp parallel for num_threads(length / BLOCK_SIZE)
+#pragma omp parallel for num_threads(dgemm_threads(length))
   for (int si = 0; si < length; si += BLOCK_SIZE)
     for (int sj = 0; sj < length; sj += BLOCK_SIZE)
-      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
-        block_perfect(length, si, sj, sk, a, b, c);
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_perfect(length, si, sj, sk, a, b, c, NULL);
+        TRACE_END("perfect", si, sj, sk);
+      }
+}
+
+void dgemm_perfect_epilogue(int length, double *a, double *b, double *c,
+                            dgemm_epilogue *epilogue) {
+#pragma omp parallel for num_threads(dgemm_threads(length))
+  for (int si = 0; si < length; si += BLOCK_SIZE)
+    for (int sj = 0; sj < length; sj += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_perfect(length, si, sj, sk, a, b, c, epilogue);
+        TRACE_END("perfect", si, sj, sk);
+      }
 }
 
 void dgemm_avx512(int length, double *a, double *b, double *c) {
@@ -407,7 +527,7 @@ void dgemm_avx512(int length, double *a, double *b, double *c) {
 void dgemm_avx512_unroll(int length, double *a, double *b, double *c) {
 #if __AVX512F__
   int i = 0;
-  for (; i < length - lenght % (UNROLL * AVX512_QT_DOUBLE);
+  for (; i < length - length % (UNROLL * AVX512_QT_DOUBLE);
        i += UNROLL * AVX512_QT_DOUBLE) {
     for (int j = 0; j < length; j++) {
       __m512d acc[UNROLL];
@@ -485,9 +605,328 @@ void dgemm_avx512_unroll_blocking(int length, double *a, double *b, double *c) {
 void dgemm_avx512_unroll_blocking_parallel(int length, double *a, double *b,
                                            double *c) {
 
-#pragma omp parallel for num_threads(length / BLOCK_SIZE)
+#pragma omp parallel for num_threads(dgemm_threads(length))
   for (int si = 0; si < length; si += BLOCK_SIZE)
     for (int sj = 0; sj < length; sj += BLOCK_SIZE)
-      for (int sk = 0; sk < length; sk += BLOCK_SIZE)
+      for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
         block_avx512_unroll(length, si, sj, sk, a, b, c);
+        TRACE_END("avx512_parallel", si, sj, sk);
+      }
+}
+
+void block_rectangular(int si, int ei, int sj, int ej, int sk, int ek,
+                       double *a, int lda, double *b, int ldb, double *c,
+                       int ldc) {
+  for (int j = sj; j < ej; j++) {
+    int i = si;
+
+#if __AVX__ || __AVX2__
+    for (; i + UNROLL * AVX256_QT_DOUBLE <= ei;
+         i += UNROLL * AVX256_QT_DOUBLE) {
+      __m256d acc[UNROLL];
+
+      for (int r = 0; r < UNROLL; r++)
+        acc[r] = _mm256_loadu_pd(c + i + j * ldc + r * AVX256_QT_DOUBLE);
+
+      for (int k = sk; k < ek; k++) {
+        __m256d column = _mm256_broadcast_sd(b + k + j * ldb);
+
+        for (int r = 0; r < UNROLL; r++) {
+          __m256d row =
+              _mm256_loadu_pd(a + i + k * lda + r * AVX256_QT_DOUBLE);
+          __m256d mul = _mm256_mul_pd(row, column);
+          acc[r] = _mm256_add_pd(acc[r], mul);
+        }
+      }
+
+      for (int r = 0; r < UNROLL; r++)
+        _mm256_storeu_pd(c + i + j * ldc + r * AVX256_QT_DOUBLE, acc[r]);
+    }
+
+    for (; i + AVX256_QT_DOUBLE <= ei; i += AVX256_QT_DOUBLE) {
+      __m256d acc = _mm256_loadu_pd(c + i + j * ldc);
+
+      for (int k = sk; k < ek; k++) {
+        __m256d row = _mm256_loadu_pd(a + i + k * lda);
+        __m256d column = _mm256_broadcast_sd(b + k + j * ldb);
+        __m256d mul = _mm256_mul_pd(row, column);
+        acc = _mm256_add_pd(acc, mul);
+      }
+
+      _mm256_storeu_pd(c + i + j * ldc, acc);
+    }
+#endif
+
+    for (; i < ei; i++)
+      for (int k = sk; k < ek; k++)
+        c[i + j * ldc] += a[i + k * lda] * b[k + j * ldb];
+  }
+}
+
+void dgemm_rectangular(int m, int n, int k, double *a, int lda, double *b,
+                       int ldb, double *c, int ldc) {
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int sj = 0; sj < n; sj += BLOCK_SIZE)
+    for (int si = 0; si < m; si += BLOCK_SIZE)
+      for (int sk = 0; sk < k; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_rectangular(si, si + BLOCK_SIZE < m ? si + BLOCK_SIZE : m, sj,
+                          sj + BLOCK_SIZE < n ? sj + BLOCK_SIZE : n, sk,
+                          sk + BLOCK_SIZE < k ? sk + BLOCK_SIZE : k, a, lda, b,
+                          ldb, c, ldc);
+        TRACE_END("rectangular", si, sj, sk);
+      }
+}
+
+size_t morton_index(int ti, int tj) {
+  size_t index = 0;
+
+  for (int bit = 0; bit < 16; bit++)
+    index |= ((size_t)(ti >> bit & 1) << (2 * bit)) |
+             ((size_t)(tj >> bit & 1) << (2 * bit + 1));
+
+  return index;
+}
+
+void copy_to_morton(int length, double *matrix, double *morton) {
+  int tiles = length / MORTON_TILE;
+
+#pragma omp parallel for collapse(2)
+  for (int tj = 0; tj < tiles; tj++)
+    for (int ti = 0; ti < tiles; ti++) {
+      double *tile = morton + morton_index(ti, tj) * MORTON_TILE * MORTON_TILE;
+
+      for (int j = 0; j < MORTON_TILE; j++)
+        for (int i = 0; i < MORTON_TILE; i++)
+          tile[i + j * MORTON_TILE] =
+              matrix[ti * MORTON_TILE + i + (tj * MORTON_TILE + j) * length];
+    }
+}
+
+void copy_from_morton(int length, double *morton, double *matrix) {
+  int tiles = length / MORTON_TILE;
+
+#pragma omp parallel for collapse(2)
+  for (int tj = 0; tj < tiles; tj++)
+    for (int ti = 0; ti < tiles; ti++) {
+      double *tile = morton + morton_index(ti, tj) * MORTON_TILE * MORTON_TILE;
+
+      for (int j = 0; j < MORTON_TILE; j++)
+        for (int i = 0; i < MORTON_TILE; i++)
+          matrix[ti * MORTON_TILE + i + (tj * MORTON_TILE + j) * length] =
+              tile[i + j * MORTON_TILE];
+    }
+}
+
+void tile_morton(double *a, double *b, double *c) {
+#if __AVX__ || __AVX2__
+  for (int j = 0; j < MORTON_TILE; j++) {
+    __m256d acc[UNROLL];
+
+    for (int r = 0; r < UNROLL; r++)
+      acc[r] = _mm256_load_pd(c + r * AVX256_QT_DOUBLE + j * MORTON_TILE);
+
+    for (int k = 0; k < MORTON_TILE; k++) {
+      __m256d column = _mm256_broadcast_sd(b + k + j * MORTON_TILE);
+
+      for (int r = 0; r < UNROLL; r++) {
+        __m256d row =
+            _mm256_load_pd(a + r * AVX256_QT_DOUBLE + k * MORTON_TILE);
+        __m256d mul = _mm256_mul_pd(row, column);
+        acc[r] = _mm256_add_pd(acc[r], mul);
+      }
+    }
+
+    for (int r = 0; r < UNROLL; r++)
+      _mm256_store_pd(c + r * AVX256_QT_DOUBLE + j * MORTON_TILE, acc[r]);
+  }
+#else
+  for (int j = 0; j < MORTON_TILE; j++)
+    for (int k = 0; k < MORTON_TILE; k++)
+      for (int i = 0; i < MORTON_TILE; i++)
+        c[i + j * MORTON_TILE] +=
+            a[i + k * MORTON_TILE] * b[k + j * MORTON_TILE];
+#endif
+}
+
+void recursive_morton(int size, int ti, int tj, int tk, int tiles, double *a,
+                      double *b, double *c) {
+  if (ti >= tiles || tj >= tiles || tk >= tiles)
+    return;
+
+  if (size == 1) {
+    TRACE_BEGIN();
+    tile_morton(a, b, c);
+    TRACE_END("morton", ti * MORTON_TILE, tj * MORTON_TILE, tk * MORTON_TILE);
+    return;
+  }
+
+  int half = size / 2;
+  size_t quadrant = (size_t)half * half * MORTON_TILE * MORTON_TILE;
+
+  for (int qj = 0; qj < 2; qj++)
+    for (int qi = 0; qi < 2; qi++) {
+#pragma omp task if (size > MORTON_TASK_CUTOFF)
+      for (int qk = 0; qk < 2; qk++)
+        recursive_morton(half, ti + qi * half, tj + qj * half, tk + qk * half,
+                         tiles, a + (qi + 2 * qk) * quadrant,
+                         b + (qk + 2 * qj) * quadrant,
+                         c + (qi + 2 * qj) * quadrant);
+    }
+
+#pragma omp taskwait
+}
+
+void dgemm_morton(int length, double *a, double *b, double *c) {
+  int tiles = length / MORTON_TILE;
+  int size = 1;
+
+  while (size < tiles)
+    size *= 2;
+
+  size_t bytes =
+      (size_t)size * size * MORTON_TILE * MORTON_TILE * sizeof(double);
+  double *ma = aligned_alloc(ALIGN, bytes);
+  double *mb = aligned_alloc(ALIGN, bytes);
+  double *mc = aligned_alloc(ALIGN, bytes);
+
+  TRACE_BEGIN();
+  copy_to_morton(length, a, ma);
+  copy_to_morton(length, b, mb);
+  copy_to_morton(length, c, mc);
+  TRACE_END("pack", 0, 0, 0);
+
+#pragma omp parallel
+#pragma omp single
+  recursive_morton(size, 0, 0, 0, tiles, ma, mb, mc);
+
+  copy_from_morton(length, mc, c);
+
+  free(ma);
+  free(mb);
+  free(mc);
 }
+
+void block_strided(int length, int si, int sj, double *a, int lda, double *b,
+                   int ldb, double *c) {
+#if __AVX__ || __AVX2__
+  for (int i = 0; i < BLOCK_SIZE; i += UNROLL * AVX256_QT_DOUBLE) {
+    for (int j = 0; j < BLOCK_SIZE; j++) {
+      double *tile = c + si + i + (size_t)(sj + j) * length;
+      __m256d acc[UNROLL];
+
+      for (int r = 0; r < UNROLL; r++)
+        acc[r] = _mm256_loadu_pd(tile + r * AVX256_QT_DOUBLE);
+
+      for (int k = 0; k < BLOCK_SIZE; k++) {
+        __m256d column = _mm256_broadcast_sd(b + k + (size_t)j * ldb);
+
+        for (int r = 0; r < UNROLL; r++) {
+          __m256d row = _mm256_loadu_pd(a + i + (size_t)k * lda +
+                                        r * AVX256_QT_DOUBLE);
+          __m256d mul = _mm256_mul_pd(row, column);
+          acc[r] = _mm256_add_pd(acc[r], mul);
+        }
+      }
+
+      for (int r = 0; r < UNROLL; r++)
+        _mm256_storeu_pd(tile + r * AVX256_QT_DOUBLE, acc[r]);
+    }
+  }
+#else
+  for (int j = 0; j < BLOCK_SIZE; j++)
+    for (int k = 0; k < BLOCK_SIZE; k++)
+      for (int i = 0; i < BLOCK_SIZE; i++)
+        c[si + i + (size_t)(sj + j) * length] +=
+            a[i + (size_t)k * lda] * b[k + (size_t)j * ldb];
+#endif
+}
+
+void wait_for(atomic_int *flag, int value) {
+  for (int spins = 1;
+       atomic_load_explicit(flag, memory_order_acquire) < value; spins++) {
+    if (spins % PIPELINE_SPINS == 0)
+      sched_yield();
+    else
+      _mm_pause();
+  }
+}
+
+void pack_panel(int length, int sk, double *a, double *b, double *panel_a,
+                double *panel_b) {
+  for (int k = 0; k < BLOCK_SIZE; k++)
+    for (int si = 0; si < length; si += BLOCK_SIZE)
+      for (int i = 0; i < BLOCK_SIZE; i++)
+        panel_a[(size_t)si * BLOCK_SIZE + i + k * BLOCK_SIZE] =
+            a[si + i + (size_t)(sk + k) * length];
+
+  for (int j = 0; j < length; j++)
+    for (int k = 0; k < BLOCK_SIZE; k++)
+      panel_b[k + (size_t)j * BLOCK_SIZE] = b[sk + k + (size_t)j * length];
+}
+
+void dgemm_pipelined(int length, double *a, double *b, double *c) {
+  int panels = length / BLOCK_SIZE;
+  size_t panel_size = (size_t)length * BLOCK_SIZE;
+  double *packed_a =
+      aligned_alloc(ALIGN, PIPELINE_DEPTH * panel_size * sizeof(double));
+  double *packed_b =
+      aligned_alloc(ALIGN, PIPELINE_DEPTH * panel_size * sizeof(double));
+  atomic_int ready[PIPELINE_DEPTH], consumed[PIPELINE_DEPTH];
+
+  for (int buffer = 0; buffer < PIPELINE_DEPTH; buffer++) {
+    atomic_init(&ready[buffer], 0);
+    atomic_init(&consumed[buffer], 0);
+  }
+
+#pragma omp parallel num_threads(dgemm_threads(length) + 1)
+  {
+    int threads = omp_get_num_threads(), id = omp_get_thread_num();
+    int consumers = threads > 1 ? threads - 1 : 1;
+    bool producer = threads == 1 || id == consumers;
+    bool consumer = threads == 1 || id < consumers;
+
+    for (int p = 0; p < panels; p++) {
+      int buffer = p % PIPELINE_DEPTH, round = p / PIPELINE_DEPTH;
+      double *panel_a = packed_a + buffer * panel_size;
+      double *panel_b = packed_b + buffer * panel_size;
+
+      if (producer) {
+        wait_for(&consumed[buffer], consumers * round);
+        TRACE_BEGIN();
+        pack_panel(length, p * BLOCK_SIZE, a, b, panel_a, panel_b);
+        TRACE_END("pack", 0, 0, p * BLOCK_SIZE);
+        atomic_store_explicit(&ready[buffer], round + 1,
+                              memory_order_release);
+      }
+
+      if (consumer) {
+        wait_for(&ready[buffer], round + 1);
+
+        for (int tile = id; tile < panels * panels; tile += consumers) {
+          int si = tile % panels * BLOCK_SIZE;
+          int sj = tile / panels * BLOCK_SIZE;
+
+          TRACE_BEGIN();
+          block_strided(length, si, sj, panel_a + (size_t)si * BLOCK_SIZE,
+                        BLOCK_SIZE, panel_b + (size_t)sj * BLOCK_SIZE,
+                        BLOCK_SIZE, c);
+          TRACE_END("pipelined", si, sj, p * BLOCK_SIZE);
+        }
+
+        atomic_fetch_add_explicit(&consumed[buffer], 1, memory_order_release);
+      }
+    }
+  }
+
+  free(packed_a);
+  free(packed_b);
+}
+
+#ifdef USE_CBLAS
+void dgemm_cblas(int length, double *a, double *b, double *c) {
+  cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, length, length,
+              length, 1, a, length, b, length, 1, c, length);
+}
+#endif
@@ -13,6 +13,10 @@
 #define AVX512_QT_DOUBLE 8
 #define SIMD_MANUAL_QT_DOUBLE 4
 #define ALIGN 64
+#define MORTON_TILE (UNROLL * AVX256_QT_DOUBLE)
+#define MORTON_TASK_CUTOFF 4
+#define PIPELINE_DEPTH 2
+#define PIPELINE_SPINS 1024
 
 #if __AVX512__
 #if BLOCK_SIZE % (AVX512_QT_DOUBLE * UNROLL) != 0
@@ -30,6 +34,21 @@
 #error BLOCK_SIZE is not a UNROLL * AVX256_QT_DOUBLE multiple
 #endif
 
+typedef enum { activation_none, activation_relu, activation_clamp } activation;
+
+typedef struct {
+  double alpha;
+  double beta;
+  double *bias;
+  activation activation;
+  double min;
+  double max;
+} dgemm_epilogue;
+
+void set_dgemm_threads(int threads);
+int dgemm_threads(int length);
+void copy_transpose(int length, double *matrix, double *transpose);
+
 void dgemm_simple(int length, double *a, double *b, double *c);
 void dgemm_transpose(int length, double *a, double *b, double *c);
 void dgemm_simd_manual(int length, double *a, double *b, double *c);
@@ -51,5 +70,21 @@ void dgemm_simd_manual_unroll_blocking_parallel(int length, double *a, double *b
 void dgemm_avx256_unroll_blocking_parallel(int length, double *a, double *b, double *c);
 void dgemm_avx512_unroll_blocking_parallel(int length, double *a, double *b, double *c);
 void dgemm_perfect(int length, double *a, double *b, double *c);
+void dgemm_avx256_unroll_blocking_epilogue(int length, double *a, double *b,
+                                           double *c, dgemm_epilogue *epilogue);
+void dgemm_avx256_unroll_blocking_parallel_epilogue(int length, double *a,
+                                                    double *b, double *c,
+                                                    dgemm_epilogue *epilogue);
+void dgemm_perfect_epilogue(int length, double *a, double *b, double *c,
+                            dgemm_epilogue *epilogue);
+void dgemm_rectangular(int m, int n, int k, double *a, int lda, double *b,
+                       int ldb, double *c, int ldc);
+void dgemm_morton(int length, double *a, double *b, double *c);
+void block_strided(int length, int si, int sj, double *a, int lda, double *b,
+                   int ldb, double *c);
+void dgemm_pipelined(int length, double *a, double *b, double *c);
+#ifdef USE_CBLAS
+void dgemm_cblas(int length, double *a, double *b, double *c);
+#endif
 
 #endif
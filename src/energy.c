@@ -0,0 +1,212 @@
+#define _GNU_SOURCE
+#include "energy.h"
+#include "affinity.h"
+#include <fcntl.h>
+#include <glob.h>
+#include <inttypes.h>
+#include <math.h>
+#include <omp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#define MSR_MPERF 0xe7
+#define MSR_APERF 0xe8
+
+bool read_u64(const char *path, uint64_t *value) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+    return false;
+
+  bool ok = fscanf(file, "%" SCNu64, value) == 1;
+  fclose(file);
+
+  return ok;
+}
+
+void open_rapl_zones(energy_meter *meter) {
+  glob_t zones;
+  meter->zones = 0;
+
+  if (glob("/sys/class/powercap/intel-rapl:*", 0, NULL, &zones) != 0)
+    return;
+
+  for (size_t z = 0; z < zones.gl_pathc && meter->zones < ENERGY_MAX_ZONES;
+       z++) {
+    char path[4096], name[64] = "";
+    uint64_t value;
+
+    snprintf(path, sizeof(path), "%s/name", zones.gl_pathv[z]);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+      continue;
+
+    bool named = fscanf(file, "%63s", name) == 1;
+    fclose(file);
+
+    if (!named || (strncmp(name, "package", 7) != 0 && strcmp(name, "dram")))
+      continue;
+
+    snprintf(path, sizeof(path), "%s/energy_uj", zones.gl_pathv[z]);
+    if (!read_u64(path, &value))
+      continue;
+
+    meter->energy[meter->zones] = strdup(path);
+
+    snprintf(path, sizeof(path), "%s/max_energy_range_uj", zones.gl_pathv[z]);
+    if (!read_u64(path, &meter->range[meter->zones]))
+      meter->range[meter->zones] = 0;
+
+    meter->zones++;
+  }
+
+  globfree(&zones);
+}
+
+bool read_msr(int fd, uint32_t reg, uint64_t *value) {
+  return pread(fd, value, sizeof(*value), reg) == sizeof(*value);
+}
+
+void open_msrs(energy_meter *meter) {
+  cpu_list cpus;
+  meter->cpus = 0;
+  meter->msr = NULL;
+  meter->aperf = NULL;
+  meter->mperf = NULL;
+
+  if (allowed_cpu_list(&cpus) != 0)
+    return;
+
+  meter->msr = malloc(cpus.count * sizeof(int));
+  meter->aperf = malloc(cpus.count * sizeof(uint64_t));
+  meter->mperf = malloc(cpus.count * sizeof(uint64_t));
+
+  for (int i = 0; i < cpus.count; i++) {
+    char path[64];
+    uint64_t value;
+
+    snprintf(path, sizeof(path), "/dev/cpu/%d/msr", cpus.cpus[i]);
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+      continue;
+
+    if (!read_msr(fd, MSR_APERF, &value)) {
+      close(fd);
+      continue;
+    }
+
+    meter->msr[meter->cpus++] = fd;
+  }
+
+  free_cpu_list(&cpus);
+
+  if (meter->cpus > 0) {
+    double start_time = omp_get_wtime();
+    uint64_t start_tsc = __rdtsc();
+
+    while (omp_get_wtime() - start_time < 0.01)
+      ;
+
+    meter->tsc_ghz =
+        (__rdtsc() - start_tsc) / (omp_get_wtime() - start_time) / 1e9;
+  }
+}
+
+double cpuinfo_mhz() {
+  FILE *file = fopen("/proc/cpuinfo", "r");
+  if (file == NULL)
+    return NAN;
+
+  char line[256];
+  double sum = 0, mhz;
+  int count = 0;
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (sscanf(line, "cpu MHz : %lf", &mhz) == 1) {
+      sum += mhz;
+      count++;
+    }
+  }
+
+  fclose(file);
+
+  return count > 0 ? sum / count : NAN;
+}
+
+void open_energy_meter(energy_meter *meter) {
+  open_rapl_zones(meter);
+  open_msrs(meter);
+
+  if (meter->zones == 0)
+    fprintf(stderr, "Warning: RAPL powercap interface not available\n");
+
+  if (meter->cpus == 0 && isnan(cpuinfo_mhz()))
+    fprintf(stderr, "Warning: Core frequency not available\n");
+}
+
+void start_energy_meter(energy_meter *meter) {
+  for (int z = 0; z < meter->zones; z++)
+    read_u64(meter->energy[z], &meter->start[z]);
+
+  for (int i = 0; i < meter->cpus; i++) {
+    read_msr(meter->msr[i], MSR_APERF, &meter->aperf[i]);
+    read_msr(meter->msr[i], MSR_MPERF, &meter->mperf[i]);
+  }
+
+  if (meter->cpus == 0)
+    meter->start_mhz = cpuinfo_mhz();
+}
+
+void stop_energy_meter(energy_meter *meter, double seconds,
+                       energy_reading *reading) {
+  uint64_t aperf = 0, mperf = 0;
+
+  for (int i = 0; i < meter->cpus; i++) {
+    uint64_t value;
+
+    if (read_msr(meter->msr[i], MSR_APERF, &value))
+      aperf += value - meter->aperf[i];
+
+    if (read_msr(meter->msr[i], MSR_MPERF, &value))
+      mperf += value - meter->mperf[i];
+  }
+
+  reading->joules = meter->zones > 0 ? 0 : NAN;
+
+  for (int z = 0; z < meter->zones; z++) {
+    uint64_t value;
+
+    if (!read_u64(meter->energy[z], &value))
+      continue;
+
+    if (value < meter->start[z])
+      value += meter->range[z];
+
+    reading->joules += (value - meter->start[z]) / 1e6;
+  }
+
+  reading->watts = reading->joules / seconds;
+
+  if (meter->cpus > 0)
+    reading->ghz = mperf > 0 ? meter->tsc_ghz * aperf / mperf : NAN;
+  else
+    reading->ghz = (meter->start_mhz + cpuinfo_mhz()) / 2 / 1000;
+}
+
+void close_energy_meter(energy_meter *meter) {
+  for (int z = 0; z < meter->zones; z++)
+    free(meter->energy[z]);
+
+  for (int i = 0; i < meter->cpus; i++)
+    close(meter->msr[i]);
+
+  free(meter->msr);
+  free(meter->aperf);
+  free(meter->mperf);
+  meter->zones = 0;
+  meter->cpus = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+
+#define ENERGY_MAX_ZONES 16
+
+typedef struct {
+  int zones;
+  char *energy[ENERGY_MAX_ZONES];
+  uint64_t range[ENERGY_MAX_ZONES];
+  uint64_t start[ENERGY_MAX_ZONES];
+  int cpus;
+  int *msr;
+  uint64_t *aperf;
+  uint64_t *mperf;
+  double tsc_ghz;
+  double start_mhz;
+} energy_meter;
+
+typedef struct {
+  double joules;
+  double watts;
+  double ghz;
+} energy_reading;
+
+void open_energy_meter(energy_meter *meter);
+void start_energy_meter(energy_meter *meter);
+void stop_energy_meter(energy_meter *meter, double seconds,
+                       energy_reading *reading);
+void close_energy_meter(energy_meter *meter);
+
+#endif
@@ -0,0 +1,99 @@
+#include "generator.h"
+#include <math.h>
+
+#define GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL
+
+const char *distribution_names[DISTRIBUTION_COUNT] = {
+    "index", "uniform", "normal", "ill_conditioned", "integer",
+};
+
+static inline uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+
+  return x;
+}
+
+static inline uint64_t stream_key(generator *generator, uint64_t stream) {
+  return mix(generator->seed ^ mix((stream + 1) * GOLDEN_GAMMA));
+}
+
+static inline double unit(uint64_t key, uint64_t counter) {
+  return (mix(key + (counter + 1) * GOLDEN_GAMMA) >> 11) * 0x1.0p-53;
+}
+
+double generator_uniform(generator *generator, uint64_t stream,
+                         uint64_t counter) {
+  return unit(stream_key(generator, stream), counter);
+}
+
+static inline double normal(uint64_t key, long index) {
+  double radius = sqrt(-2 * log(1 - unit(key, 2 * index)));
+  return radius * cos(2 * M_PI * unit(key, 2 * index + 1));
+}
+
+static inline double ill_conditioned(uint64_t key, long index, int rows,
+                                     double decay) {
+  return (1 + 3 * unit(key, index)) * exp(decay * (index / rows));
+}
+
+static inline double ill_conditioned_decay(int columns) {
+  return -ILL_CONDITIONED_DIGITS * log(10) / (columns > 1 ? columns - 1 : 1);
+}
+
+double generator_value(generator *generator, uint64_t stream, int rows,
+                       int columns, long index) {
+  uint64_t key = stream_key(generator, stream);
+
+  switch (generator->distribution) {
+  case distribution_uniform:
+    return 4 * unit(key, index);
+  case distribution_normal:
+    return normal(key, index);
+  case distribution_ill_conditioned:
+    return ill_conditioned(key, index, rows, ill_conditioned_decay(columns));
+  case distribution_integer:
+    return floor(9 * unit(key, index)) - 4;
+  default:
+    return index;
+  }
+}
+
+void generate_matrix(generator *generator, uint64_t stream, int rows,
+                     int columns, double *matrix) {
+  uint64_t key = stream_key(generator, stream);
+  long count = (long)rows * columns;
+  double decay = ill_conditioned_decay(columns);
+
+  switch (generator->distribution) {
+  case DISTRIBUTION_COUNT:
+  case distribution_index:
+#pragma omp parallel for simd schedule(static)
+    for (long index = 0; index < count; index++)
+      matrix[index] = index;
+    break;
+  case distribution_uniform:
+#pragma omp parallel for simd schedule(static)
+    for (long index = 0; index < count; index++)
+      matrix[index] = 4 * unit(key, index);
+    break;
+  case distribution_normal:
+#pragma omp parallel for schedule(static)
+    for (long index = 0; index < count; index++)
+      matrix[index] = normal(key, index);
+    break;
+  case distribution_ill_conditioned:
+#pragma omp parallel for schedule(static)
+    for (long index = 0; index < count; index++)
+      matrix[index] = ill_conditioned(key, index, rows, decay);
+    break;
+  case distribution_integer:
+#pragma omp parallel for simd schedule(static)
+    for (long index = 0; index < count; index++)
+      matrix[index] = floor(9 * unit(key, index)) - 4;
+    break;
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdint.h>
+
+#define ILL_CONDITIONED_DIGITS 12
+
+typedef enum {
+  distribution_index,
+  distribution_uniform,
+  distribution_normal,
+  distribution_ill_conditioned,
+  distribution_integer,
+  DISTRIBUTION_COUNT
+} distribution;
+
+typedef enum {
+  stream_a,
+  stream_b,
+  stream_bias,
+  stream_mask,
+  stream_chain
+} generator_stream;
+
+typedef struct {
+  uint64_t seed;
+  distribution distribution;
+} generator;
+
+extern const char *distribution_names[DISTRIBUTION_COUNT];
+
+double generator_uniform(generator *generator, uint64_t stream,
+                         uint64_t counter);
+double generator_value(generator *generator, uint64_t stream, int rows,
+                       int columns, long index);
+void generate_matrix(generator *generator, uint64_t stream, int rows,
+                     int columns, double *matrix);
+
+#endif
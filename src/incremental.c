@@ -0,0 +1,251 @@
+#include "incremental.h"
+#include "dgemm.h"
+#include "trace.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct incremental {
+  int length;
+  int padded;
+  int blocks;
+  double *operands[OPERAND_COUNT];
+  double *snapshots[OPERAND_COUNT];
+  double *deltas[OPERAND_COUNT];
+  uint64_t *checksums[OPERAND_COUNT];
+  bool *dirty[OPERAND_COUNT];
+  double *c;
+};
+
+uint64_t block_checksum(incremental *tracker, double *matrix, int si, int sj) {
+  int length = tracker->length;
+  int ei = si + BLOCK_SIZE < length ? si + BLOCK_SIZE : length;
+  int ej = sj + BLOCK_SIZE < length ? sj + BLOCK_SIZE : length;
+  uint64_t sum = 0;
+
+  for (int j = sj; j < ej; j++)
+    for (int i = si; i < ei; i++) {
+      uint64_t bits, index = (i - si) + (uint64_t)(j - sj) * BLOCK_SIZE;
+
+      memcpy(&bits, matrix + i + (size_t)j * length, sizeof(bits));
+      sum += (bits ^ (bits >> 29)) * (INCREMENTAL_SEED + 2 * index);
+    }
+
+  return sum;
+}
+
+void compute_deltas(incremental *tracker, incremental_operand operand) {
+  int length = tracker->length, padded = tracker->padded,
+      blocks = tracker->blocks;
+  double *source = tracker->operands[operand],
+         *snapshot = tracker->snapshots[operand],
+         *delta = tracker->deltas[operand];
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int bj = 0; bj < blocks; bj++)
+    for (int bi = 0; bi < blocks; bi++) {
+      if (!tracker->dirty[operand][bi + (size_t)bj * blocks])
+        continue;
+
+      int si = bi * BLOCK_SIZE, sj = bj * BLOCK_SIZE;
+      int ei = si + BLOCK_SIZE < length ? si + BLOCK_SIZE : length;
+      int ej = sj + BLOCK_SIZE < length ? sj + BLOCK_SIZE : length;
+
+      for (int j = sj; j < ej; j++)
+        for (int i = si; i < ei; i++)
+          delta[i + (size_t)j * padded] =
+              source[i + (size_t)j * length] - snapshot[i + (size_t)j * padded];
+    }
+}
+
+void copy_snapshots(incremental *tracker, incremental_operand operand) {
+  int length = tracker->length, padded = tracker->padded,
+      blocks = tracker->blocks;
+  double *source = tracker->operands[operand],
+         *snapshot = tracker->snapshots[operand];
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int bj = 0; bj < blocks; bj++)
+    for (int bi = 0; bi < blocks; bi++) {
+      size_t index = bi + (size_t)bj * blocks;
+
+      if (!tracker->dirty[operand][index])
+        continue;
+
+      int si = bi * BLOCK_SIZE, sj = bj * BLOCK_SIZE;
+      int ei = si + BLOCK_SIZE < length ? si + BLOCK_SIZE : length;
+      int ej = sj + BLOCK_SIZE < length ? sj + BLOCK_SIZE : length;
+
+      for (int j = sj; j < ej; j++)
+        memcpy(snapshot + si + (size_t)j * padded,
+               source + si + (size_t)j * length, (ei - si) * sizeof(double));
+
+      tracker->checksums[operand][index] =
+          block_checksum(tracker, source, si, sj);
+    }
+}
+
+void recompute(incremental *tracker) {
+  int padded = tracker->padded;
+  double *a = tracker->snapshots[operand_a], *b = tracker->snapshots[operand_b],
+         *c = tracker->c;
+
+  memset(c, 0, (size_t)padded * padded * sizeof(double));
+
+#pragma omp parallel for collapse(2)
+  for (int sj = 0; sj < padded; sj += BLOCK_SIZE)
+    for (int si = 0; si < padded; si += BLOCK_SIZE)
+      for (int sk = 0; sk < padded; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_strided(padded, si, sj, a + si + (size_t)sk * padded, padded,
+                      b + sk + (size_t)sj * padded, padded, c);
+        TRACE_END("incremental", si, sj, sk);
+      }
+}
+
+void correct(incremental *tracker) {
+  int padded = tracker->padded, blocks = tracker->blocks;
+  bool *dirty_a = tracker->dirty[operand_a], *dirty_b = tracker->dirty[operand_b];
+  double *a = tracker->snapshots[operand_a], *b = tracker->snapshots[operand_b],
+         *delta_a = tracker->deltas[operand_a],
+         *delta_b = tracker->deltas[operand_b], *c = tracker->c;
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int bj = 0; bj < blocks; bj++)
+    for (int bi = 0; bi < blocks; bi++)
+      for (int bk = 0; bk < blocks; bk++) {
+        int si = bi * BLOCK_SIZE, sj = bj * BLOCK_SIZE, sk = bk * BLOCK_SIZE;
+
+        if (dirty_a[bi + (size_t)bk * blocks]) {
+          TRACE_BEGIN();
+          block_strided(padded, si, sj, delta_a + si + (size_t)sk * padded,
+                        padded, b + sk + (size_t)sj * padded, padded, c);
+          TRACE_END("correction", si, sj, sk);
+        }
+
+        if (dirty_b[bk + (size_t)bj * blocks]) {
+          TRACE_BEGIN();
+          block_strided(padded, si, sj, a + si + (size_t)sk * padded, padded,
+                        delta_b + sk + (size_t)sj * padded, padded, c);
+          TRACE_END("correction", si, sj, sk);
+        }
+      }
+}
+
+incremental *create_incremental(int length, double *a, double *b) {
+  incremental *tracker = malloc(sizeof(incremental));
+  tracker->length = length;
+  tracker->padded = (length + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  tracker->blocks = tracker->padded / BLOCK_SIZE;
+  tracker->operands[operand_a] = a;
+  tracker->operands[operand_b] = b;
+
+  size_t size = (size_t)tracker->padded * tracker->padded * sizeof(double);
+  size_t flags = (size_t)tracker->blocks * tracker->blocks;
+
+  for (int operand = operand_a; operand < OPERAND_COUNT; operand++) {
+    tracker->snapshots[operand] = aligned_alloc(ALIGN, size);
+    tracker->deltas[operand] = aligned_alloc(ALIGN, size);
+    tracker->checksums[operand] = malloc(flags * sizeof(uint64_t));
+    tracker->dirty[operand] = calloc(flags, sizeof(bool));
+
+    memset(tracker->snapshots[operand], 0, size);
+    memset(tracker->deltas[operand], 0, size);
+
+    mark_dirty(tracker, operand, 0, 0, length, length);
+    copy_snapshots(tracker, operand);
+    memset(tracker->dirty[operand], 0, flags * sizeof(bool));
+  }
+
+  tracker->c = aligned_alloc(ALIGN, size);
+  recompute(tracker);
+
+  return tracker;
+}
+
+void mark_dirty(incremental *tracker, incremental_operand operand, int row,
+                int column, int rows, int columns) {
+  int length = tracker->length;
+  int er = row + rows < length ? row + rows : length;
+  int ec = column + columns < length ? column + columns : length;
+
+  row = row > 0 ? row : 0;
+  column = column > 0 ? column : 0;
+
+  for (int bj = column / BLOCK_SIZE; bj * BLOCK_SIZE < ec; bj++)
+    for (int bi = row / BLOCK_SIZE; bi * BLOCK_SIZE < er; bi++)
+      tracker->dirty[operand][bi + (size_t)bj * tracker->blocks] = true;
+}
+
+int scan_dirty(incremental *tracker) {
+  int blocks = tracker->blocks, count = 0;
+
+  for (int operand = operand_a; operand < OPERAND_COUNT; operand++) {
+#pragma omp parallel for collapse(2) reduction(+ : count)
+    for (int bj = 0; bj < blocks; bj++)
+      for (int bi = 0; bi < blocks; bi++) {
+        size_t index = bi + (size_t)bj * blocks;
+        uint64_t checksum =
+            block_checksum(tracker, tracker->operands[operand],
+                           bi * BLOCK_SIZE, bj * BLOCK_SIZE);
+
+        if (checksum != tracker->checksums[operand][index]) {
+          tracker->dirty[operand][index] = true;
+          count++;
+        }
+      }
+  }
+
+  return count;
+}
+
+double update_incremental(incremental *tracker, double *c) {
+  int length = tracker->length, padded = tracker->padded,
+      blocks = tracker->blocks;
+  size_t flags = (size_t)blocks * blocks;
+  int dirty = 0;
+
+  for (int operand = operand_a; operand < OPERAND_COUNT; operand++)
+    for (size_t index = 0; index < flags; index++)
+      dirty += tracker->dirty[operand][index];
+
+  double work = (double)dirty / flags;
+
+  if (work >= 1) {
+    copy_snapshots(tracker, operand_a);
+    copy_snapshots(tracker, operand_b);
+    recompute(tracker);
+    work = 1;
+  } else if (work > 0) {
+    compute_deltas(tracker, operand_a);
+    compute_deltas(tracker, operand_b);
+    copy_snapshots(tracker, operand_a);
+    correct(tracker);
+    copy_snapshots(tracker, operand_b);
+  }
+
+  for (int operand = operand_a; operand < OPERAND_COUNT; operand++)
+    memset(tracker->dirty[operand], 0, flags * sizeof(bool));
+
+  if (c != NULL) {
+#pragma omp parallel for
+    for (int j = 0; j < length; j++)
+      memcpy(c + (size_t)j * length, tracker->c + (size_t)j * padded,
+             length * sizeof(double));
+  }
+
+  return work;
+}
+
+void free_incremental(incremental *tracker) {
+  for (int operand = operand_a; operand < OPERAND_COUNT; operand++) {
+    free(tracker->snapshots[operand]);
+    free(tracker->deltas[operand]);
+    free(tracker->checksums[operand]);
+    free(tracker->dirty[operand]);
+  }
+
+  free(tracker->c);
+  free(tracker);
+}
@@ -0,0 +1,17 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#define INCREMENTAL_SEED 0x9E3779B97F4A7C15ULL
+
+typedef enum { operand_a, operand_b, OPERAND_COUNT } incremental_operand;
+
+typedef struct incremental incremental;
+
+incremental *create_incremental(int length, double *a, double *b);
+void mark_dirty(incremental *tracker, incremental_operand operand, int row,
+                int column, int rows, int columns);
+int scan_dirty(incremental *tracker);
+double update_incremental(incremental *tracker, double *c);
+void free_incremental(incremental *tracker);
+
+#endif
@@ -0,0 +1,279 @@
+#include "level2.h"
+#include "dgemm.h"
+#include <omp.h>
+#include <stdlib.h>
+#include <x86intrin.h>
+
+double *gather(int n, double *x, int inc) {
+  if (inc == 1)
+    return x;
+
+  double *copy = malloc(n * sizeof(double));
+
+  for (int i = 0; i < n; i++)
+    copy[i] = x[(size_t)i * inc];
+
+  return copy;
+}
+
+void scatter(int n, double *copy, double *x, int inc) {
+  if (inc == 1)
+    return;
+
+  for (int i = 0; i < n; i++)
+    x[(size_t)i * inc] = copy[i];
+
+  free(copy);
+}
+
+#if __AVX__ || __AVX2__
+double horizontal_sum(__m256d vector) {
+  __m128d low = _mm256_castpd256_pd128(vector);
+  __m128d high = _mm256_extractf128_pd(vector, 1);
+  __m128d sum = _mm_add_pd(low, high);
+
+  return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+#endif
+
+void gemv_n(int m, int n, double *a, int lda, double *x, int incx,
+            double *y) {
+#pragma omp parallel for schedule(static)
+  for (int si = 0; si < m; si += GEMV_ROWS) {
+    int ei = si + GEMV_ROWS < m ? si + GEMV_ROWS : m;
+    int j = 0;
+
+    for (; j + 4 <= n; j += 4) {
+      double *a0 = a + (size_t)j * lda, *a1 = a0 + lda, *a2 = a1 + lda,
+             *a3 = a2 + lda;
+      double x0 = x[(size_t)j * incx], x1 = x[(size_t)(j + 1) * incx],
+             x2 = x[(size_t)(j + 2) * incx], x3 = x[(size_t)(j + 3) * incx];
+      int i = si;
+
+#if __AVX__ || __AVX2__
+      __m256d column0 = _mm256_set1_pd(x0), column1 = _mm256_set1_pd(x1),
+              column2 = _mm256_set1_pd(x2), column3 = _mm256_set1_pd(x3);
+
+      for (; i + AVX256_QT_DOUBLE <= ei; i += AVX256_QT_DOUBLE) {
+        __m256d acc = _mm256_loadu_pd(y + i);
+        __m256d mul0 = _mm256_mul_pd(_mm256_loadu_pd(a0 + i), column0);
+        __m256d mul1 = _mm256_mul_pd(_mm256_loadu_pd(a1 + i), column1);
+        __m256d mul2 = _mm256_mul_pd(_mm256_loadu_pd(a2 + i), column2);
+        __m256d mul3 = _mm256_mul_pd(_mm256_loadu_pd(a3 + i), column3);
+
+        acc = _mm256_add_pd(acc, mul0);
+        acc = _mm256_add_pd(acc, mul1);
+        acc = _mm256_add_pd(acc, mul2);
+        acc = _mm256_add_pd(acc, mul3);
+
+        _mm256_storeu_pd(y + i, acc);
+      }
+#endif
+
+      for (; i < ei; i++) {
+        y[i] += a0[i] * x0;
+        y[i] += a1[i] * x1;
+        y[i] += a2[i] * x2;
+        y[i] += a3[i] * x3;
+      }
+    }
+
+    for (; j < n; j++)
+      for (int i = si; i < ei; i++)
+        y[i] += a[i + (size_t)j * lda] * x[(size_t)j * incx];
+  }
+}
+
+void gemv_t(int m, int n, double *a, int lda, double *x, double *y,
+            int incy) {
+#pragma omp parallel for schedule(static)
+  for (int sj = 0; sj < n; sj += 4) {
+    int count = sj + 4 < n ? 4 : n - sj;
+    double *column[4], sum[4] = {0, 0, 0, 0};
+    int i = 0;
+
+    for (int c = 0; c < 4; c++)
+      column[c] = a + (size_t)(sj + (c < count ? c : 0)) * lda;
+
+#if __AVX__ || __AVX2__
+    __m256d acc[4];
+
+    for (int c = 0; c < 4; c++)
+      acc[c] = _mm256_setzero_pd();
+
+    for (; i + AVX256_QT_DOUBLE <= m; i += AVX256_QT_DOUBLE) {
+      __m256d row = _mm256_loadu_pd(x + i);
+
+      for (int c = 0; c < 4; c++)
+        acc[c] = _mm256_add_pd(
+            acc[c], _mm256_mul_pd(_mm256_loadu_pd(column[c] + i), row));
+    }
+
+    for (int c = 0; c < 4; c++)
+      sum[c] = horizontal_sum(acc[c]);
+#endif
+
+    for (; i < m; i++)
+      for (int c = 0; c < 4; c++)
+        sum[c] += column[c][i] * x[i];
+
+    for (int c = 0; c < count; c++)
+      y[(size_t)(sj + c) * incy] += sum[c];
+  }
+}
+
+void dgemv(bool transpose, int m, int n, double *a, int lda, double *x,
+           int incx, double *y, int incy) {
+  if (!transpose) {
+    double *new_y = gather(m, y, incy);
+    gemv_n(m, n, a, lda, x, incx, new_y);
+    scatter(m, new_y, y, incy);
+  } else {
+    double *new_x = gather(m, x, incx);
+    gemv_t(m, n, a, lda, new_x, y, incy);
+
+    if (new_x != x)
+      free(new_x);
+  }
+}
+
+void dger(int m, int n, double *x, int incx, double *y, int incy, double *a,
+          int lda) {
+  double *new_x = gather(m, x, incx);
+
+#pragma omp parallel for schedule(static)
+  for (int j = 0; j < n; j++) {
+    double *column = a + (size_t)j * lda;
+    double yj = y[(size_t)j * incy];
+    int i = 0;
+
+#if __AVX__ || __AVX2__
+    __m256d scale = _mm256_set1_pd(yj);
+
+    for (; i + AVX256_QT_DOUBLE <= m; i += AVX256_QT_DOUBLE) {
+      __m256d mul = _mm256_mul_pd(_mm256_loadu_pd(new_x + i), scale);
+      _mm256_storeu_pd(column + i,
+                       _mm256_add_pd(_mm256_loadu_pd(column + i), mul));
+    }
+#endif
+
+    for (; i < m; i++)
+      column[i] += new_x[i] * yj;
+  }
+
+  if (new_x != x)
+    free(new_x);
+}
+
+void dgemm_small(int m, int n, int k, double *a, int lda, double *b, int ldb,
+                 double *c, int ldc) {
+  double *panel = calloc((size_t)k * SMALL_PANEL, sizeof(double));
+
+  for (int p = 0; p < k; p++)
+    for (int j = 0; j < n; j++)
+      panel[(size_t)p * SMALL_PANEL + j] = b[p + (size_t)j * ldb];
+
+#pragma omp parallel for schedule(static)
+  for (int si = 0; si < m; si += GEMV_ROWS)
+    for (int sk = 0; sk < k; sk += SMALL_DEPTH) {
+      int ei = si + GEMV_ROWS < m ? si + GEMV_ROWS : m;
+      int ek = sk + SMALL_DEPTH < k ? sk + SMALL_DEPTH : k;
+      int i = si;
+
+#if __AVX__ || __AVX2__
+      for (; i + AVX256_QT_DOUBLE <= ei; i += AVX256_QT_DOUBLE) {
+        __m256d acc[SMALL_PANEL];
+
+        for (int j = 0; j < SMALL_PANEL; j++)
+          acc[j] = j < n ? _mm256_loadu_pd(c + i + (size_t)j * ldc)
+                         : _mm256_setzero_pd();
+
+        for (int p = sk; p < ek; p++) {
+          __m256d row = _mm256_loadu_pd(a + i + (size_t)p * lda);
+          double *coefficients = panel + (size_t)p * SMALL_PANEL;
+
+          for (int j = 0; j < SMALL_PANEL; j++) {
+            __m256d column = _mm256_broadcast_sd(coefficients + j);
+            acc[j] = _mm256_add_pd(acc[j], _mm256_mul_pd(row, column));
+          }
+        }
+
+        for (int j = 0; j < n; j++)
+          _mm256_storeu_pd(c + i + (size_t)j * ldc, acc[j]);
+      }
+#endif
+
+      for (; i < ei; i++)
+        for (int j = 0; j < n; j++)
+          for (int p = sk; p < ek; p++)
+            c[i + (size_t)j * ldc] +=
+                a[i + (size_t)p * lda] * panel[(size_t)p * SMALL_PANEL + j];
+    }
+
+  free(panel);
+}
+
+void dgemm_dispatch(int m, int n, int k, double *a, int lda, double *b,
+                    int ldb, double *c, int ldc) {
+  if (m == 0 || n == 0 || k == 0)
+    return;
+
+  if (n == 1)
+    dgemv(false, m, k, a, lda, b, 1, c, 1);
+  else if (m == 1)
+    dgemv(true, k, n, b, ldb, a, lda, c, ldc);
+  else if (k == 1)
+    dger(m, n, a, 1, b, ldb, c, ldc);
+  else if (n <= SMALL_PANEL)
+    dgemm_small(m, n, k, a, lda, b, ldb, c, ldc);
+  else
+    dgemm_rectangular(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+double measure_bandwidth(size_t bytes, bool update) {
+  size_t length = bytes / ((update ? 1 : 2) * sizeof(double));
+  length = length > AVX256_QT_DOUBLE ? length : AVX256_QT_DOUBLE;
+
+  size_t size = length * sizeof(double);
+  size_t passes = BANDWIDTH_LENGTH / length;
+  passes = passes > 0 ? passes : 1;
+
+  double *a = aligned_alloc(ALIGN, size);
+  double *b = aligned_alloc(ALIGN, size);
+  double best = 0;
+
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < length; i++) {
+    a[i] = 1;
+    b[i] = 2;
+  }
+
+  for (int r = 0; r < BANDWIDTH_REPEAT; r++) {
+    double start_time = omp_get_wtime(), sum = 0;
+
+    for (size_t p = 0; p < passes; p++) {
+      if (update) {
+        double scale = p % 2 == 0 ? 2 : 0.5;
+
+#pragma omp parallel for simd schedule(static)
+        for (size_t i = 0; i < length; i++)
+          a[i] *= scale;
+
+        sum += a[0];
+      } else {
+#pragma omp parallel for simd schedule(static) reduction(+ : sum)
+        for (size_t i = 0; i < length; i++)
+          sum += a[i] * b[i];
+      }
+    }
+
+    double seconds = omp_get_wtime() - start_time;
+    double bandwidth = 2 * size * passes / seconds / 1e9;
+    best = bandwidth > best && sum > 0 ? bandwidth : best;
+  }
+
+  free(a);
+  free(b);
+
+  return best;
+}
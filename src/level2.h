@@ -0,0 +1,23 @@
+#ifndef LEVEL2_H
+#define LEVEL2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define GEMV_ROWS 512
+#define SMALL_PANEL 8
+#define SMALL_DEPTH 16
+#define BANDWIDTH_LENGTH (1 << 25)
+#define BANDWIDTH_REPEAT 10
+
+void dgemv(bool transpose, int m, int n, double *a, int lda, double *x,
+           int incx, double *y, int incy);
+void dger(int m, int n, double *x, int incx, double *y, int incy, double *a,
+          int lda);
+void dgemm_small(int m, int n, int k, double *a, int lda, double *b, int ldb,
+                 double *c, int ldc);
+void dgemm_dispatch(int m, int n, int k, double *a, int lda, double *b,
+                    int ldb, double *c, int ldc);
+double measure_bandwidth(size_t bytes, bool update);
+
+#endif
@@ -1,4 +1,18 @@
+#include "affinity.h"
+#include "chain.h"
+#include "client.h"
 #include "dgemm.h"
+#include "energy.h"
+#include "generator.h"
+#include "incremental.h"
+#include "level2.h"
+#include "multiply.h"
+#include "packed.h"
+#include "server.h"
+#include "sparse.h"
+#include "summa.h"
+#include "topology.h"
+#include "trace.h"
 #include <errno.h>
 #include <float.h>
 #include <getopt.h>
@@ -9,56 +23,49 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
-typedef enum {
-  simple,
-  transpose,
-  simd_manual,
-  avx256,
-  avx512,
-  simple_unroll,
-  transpose_unroll,
-  simd_manual_unroll,
-  avx256_unroll,
-  avx512_unroll,
-  simple_unroll_blocking,
-  transpose_unroll_blocking,
-  simd_manual_unroll_blocking,
-  avx256_unroll_blocking,
-  avx512_unroll_blocking,
-  simple_unroll_blocking_parallel,
-  transpose_unroll_blocking_parallel,
-  simd_manual_unroll_blocking_parallel,
-  avx256_unroll_blocking_parallel,
-  avx512_unroll_blocking_parallel,
-  perfect,
-  DGEMM_COUNT
-} dgemm;
-
-const char *dgemm_names[DGEMM_COUNT] = {
-    "simple",
-    "transpose",
-    "simd_manual",
-    "avx256",
-    "avx512",
-    "simple_unroll",
-    "transpose_unroll",
-    "simd_manual_unroll",
-    "avx256_unroll",
-    "avx512_unroll",
-    "simple_blocking",
-    "transpose_blocking",
-    "simd_manual_blocking",
-    "avx256_blocking",
-    "avx512_blocking",
-    "simple_parallel",
-    "transpose_parallel",
-    "simd_manual_parallel",
-    "avx256_parallel",
-    "avx512_parallel",
-    "perfect",
-};
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+typedef enum { scaling_none, scaling_strong, scaling_weak } scaling_mode;
+
+const char *scaling_names[3] = {"none", "strong", "weak"};
+
+typedef struct {
+  bool dgemms[DGEMM_COUNT];
+  int length;
+  int loop[3];
+  bool random;
+  bool show_result;
+  bool show_matrices;
+  bool parallel;
+  double density[3];
+  double incremental[3];
+  char *server;
+  char *load;
+  int clients;
+  int requests;
+  char *chain;
+  bool calibrate;
+  bool use_epilogue;
+  bool bias;
+  dgemm_epilogue epilogue;
+  int grid[2];
+  cpu_list cpus;
+  bool latency;
+  int throughput;
+  int repeat;
+  generator generator;
+  bool energy;
+  char *trace;
+  int prepacked;
+  bool physical_cores;
+  bool topology;
+  bool level2;
+  scaling_mode scaling;
+} options;
+
 
 int process_dgemms(char *option, bool dgemms[]) {
   int exit_code = EXIT_SUCCESS;
@@ -156,11 +163,152 @@ int process_loop(char *option, int *loop) {
   return exit_code;
 }
 
+int process_density(char *option, const char *name, double *density) {
+  density[0] = 0.01;
+  density[1] = 0.5;
+  density[2] = 0.01;
+
+  int exit_code = EXIT_SUCCESS;
+  int i = 0;
+
+  char *token;
+  const char delimiter[] = ":";
+  char *endptr;
+
+  token = strtok(option, delimiter);
+  while (token != NULL) {
+    if (i >= 3) {
+      fprintf(stderr, "Error: Invalid %s '%s'\n", name, option);
+      exit_code = EXIT_FAILURE;
+      break;
+    }
+
+    errno = 0;
+    double double_val = strtod(token, &endptr);
+
+    if (errno != 0 || *endptr != '\0' || double_val <= 0 || double_val > 1) {
+      fprintf(stderr, "Error: Invalid %s '%s'\n", name, option);
+      exit_code = EXIT_FAILURE;
+    }
+
+    density[i] = double_val;
+
+    token = strtok(NULL, delimiter);
+    i++;
+  }
+
+  if (density[0] > density[1]) {
+    fprintf(stderr, "Error: Invalid %s '%s'\n", name, option);
+    exit_code = EXIT_FAILURE;
+  }
+
+  return exit_code;
+}
+
+int process_count(char *option, const char *name, int *count) {
+  char *endptr;
+  errno = 0;
+
+  long int_val = strtol(option, &endptr, 10);
+
+  if (errno != 0 || *endptr != '\0' || int_val <= 0 || int_val > INT_MAX) {
+    fprintf(stderr, "Error: Invalid %s '%s'\n", name, option);
+    return EXIT_FAILURE;
+  }
+
+  *count = (int)int_val;
+
+  return EXIT_SUCCESS;
+}
+
+int process_double(char *option, const char *name, double *value) {
+  char *endptr;
+  errno = 0;
+
+  double double_val = strtod(option, &endptr);
+
+  if (errno != 0 || *endptr != '\0') {
+    fprintf(stderr, "Error: Invalid %s '%s'\n", name, option);
+    return EXIT_FAILURE;
+  }
+
+  *value = double_val;
+
+  return EXIT_SUCCESS;
+}
+
+int process_activation(char *option, dgemm_epilogue *epilogue) {
+  if (strcmp(option, "none") == 0) {
+    epilogue->activation = activation_none;
+  } else if (strcmp(option, "relu") == 0) {
+    epilogue->activation = activation_relu;
+  } else if (sscanf(option, "clamp:%lf:%lf", &epilogue->min, &epilogue->max) ==
+                 2 &&
+             epilogue->min <= epilogue->max) {
+    epilogue->activation = activation_clamp;
+  } else {
+    fprintf(stderr, "Error: Invalid activation '%s'\n", option);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int process_grid(char *option, int grid[2]) {
+  char end;
+
+  if (sscanf(option, "%dx%d%c", &grid[0], &grid[1], &end) != 2 ||
+      grid[0] <= 0 || grid[1] <= 0) {
+    fprintf(stderr, "Error: Invalid grid '%s'\n", option);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int process_seed(char *option, uint64_t *seed) {
+  char *endptr;
+  errno = 0;
+
+  unsigned long long seed_val = strtoull(option, &endptr, 0);
+
+  if (errno != 0 || *endptr != '\0' || *option == '-') {
+    fprintf(stderr, "Error: Invalid seed '%s'\n", option);
+    return EXIT_FAILURE;
+  }
+
+  *seed = seed_val;
+
+  return EXIT_SUCCESS;
+}
+
+int process_distribution(char *option, distribution *distribution) {
+  for (int i = distribution_uniform; i < DISTRIBUTION_COUNT; i++) {
+    if (strcmp(option, distribution_names[i]) == 0) {
+      *distribution = i;
+      return EXIT_SUCCESS;
+    }
+  }
+
+  fprintf(stderr, "Error: Invalid distribution '%s'\n", option);
+  return EXIT_FAILURE;
+}
+
+int process_scaling(char *option, scaling_mode *scaling) {
+  for (int i = scaling_strong; i <= scaling_weak; i++) {
+    if (strcmp(option, scaling_names[i]) == 0) {
+      *scaling = i;
+      return EXIT_SUCCESS;
+    }
+  }
+
+  fprintf(stderr, "Error: Invalid scaling '%s'\n", option);
+  return EXIT_FAILURE;
+}
+
 void print_help() { printf("Usage:..."); }
 
-void parse_options(int argc, char *argv[], bool dgemms[], int *length,
-                   int loop[3], bool *random, bool *show_result,
-                   bool *show_matrices, bool *parallel) {
+void parse_options(int argc, char *argv[], options *options) {
   struct option long_options[] = {{"dgemm", required_argument, NULL, 'd'},
                                   {"length", required_argument, NULL, 'l'},
                                   {"loop", required_argument, NULL, 'o'},
@@ -168,6 +316,35 @@ void parse_options(int argc, char *argv[], bool dgemms[], int *length,
                                   {"show-result", no_argument, NULL, 's'},
                                   {"show-matrices", no_argument, NULL, 'm'},
                                   {"parallel", no_argument, NULL, 'm'},
+                                  {"density-sweep", required_argument, NULL,
+                                   'D'},
+                                  {"server", required_argument, NULL, 'S'},
+                                  {"load", required_argument, NULL, 'L'},
+                                  {"clients", required_argument, NULL, 'c'},
+                                  {"requests", required_argument, NULL, 'n'},
+                                  {"chain", required_argument, NULL, 'C'},
+                                  {"calibrate", no_argument, NULL, 'k'},
+                                  {"alpha", required_argument, NULL, 'A'},
+                                  {"beta", required_argument, NULL, 'B'},
+                                  {"bias", no_argument, NULL, 'b'},
+                                  {"activation", required_argument, NULL, 'a'},
+                                  {"summa", required_argument, NULL, 'G'},
+                                  {"cpus", required_argument, NULL, 'P'},
+                                  {"latency", no_argument, NULL, 'T'},
+                                  {"throughput", required_argument, NULL, 'K'},
+                                  {"repeat", required_argument, NULL, 'R'},
+                                  {"seed", required_argument, NULL, 'e'},
+                                  {"distribution", required_argument, NULL,
+                                   'g'},
+                                  {"energy", no_argument, NULL, 'E'},
+                                  {"trace", required_argument, NULL, 't'},
+                                  {"prepacked", required_argument, NULL, 'M'},
+                                  {"physical-cores", no_argument, NULL, 'H'},
+                                  {"topology", no_argument, NULL, 'I'},
+                                  {"level2", no_argument, NULL, 'V'},
+                                  {"scaling", required_argument, NULL, 'W'},
+                                  {"incremental", required_argument, NULL,
+                                   'U'},
                                   {"help", no_argument, NULL, 'h'},
                                   {NULL, 0, NULL, 0}};
 
@@ -175,33 +352,127 @@ void parse_options(int argc, char *argv[], bool dgemms[], int *length,
 
   int option, exit_code = EXIT_SUCCESS;
 
-  while ((option = getopt_long(argc, argv, "d:l:o:rsmph", long_options,
-                               NULL)) != -1) {
+  while ((option = getopt_long(argc, argv,
+                               "d:l:o:rsmpD:S:L:c:n:C:kA:B:ba:G:P:TK:R:e:g:Et:M:HIVW:U:h",
+                               long_options, NULL)) != -1) {
     switch (option) {
     case 'd':
-      exit_code += process_dgemms(optarg, dgemms);
+      exit_code += process_dgemms(optarg, options->dgemms);
       is_set_dgemms = true;
       break;
     case 'l':
-      exit_code += process_length(optarg, length);
+      exit_code += process_length(optarg, &options->length);
       is_set_length = true;
       break;
     case 'o':
-      exit_code += process_loop(optarg, loop);
+      exit_code += process_loop(optarg, options->loop);
       is_set_length = true;
       break;
     case 'r':
-      *random = true;
+      options->random = true;
       break;
     case 's':
-      *show_result = true;
+      options->show_result = true;
       break;
     case 'm':
-      *show_result = true;
-      *show_matrices = true;
+      options->show_result = true;
+      options->show_matrices = true;
       break;
     case 'p':
-      *parallel = true;
+      options->parallel = true;
+      break;
+    case 'D':
+      exit_code += process_density(optarg, "density", options->density);
+      break;
+    case 'S':
+      options->server = optarg;
+      break;
+    case 'L':
+      options->load = optarg;
+      break;
+    case 'c':
+      exit_code += process_count(optarg, "clients", &options->clients);
+      break;
+    case 'n':
+      exit_code += process_count(optarg, "requests", &options->requests);
+      break;
+    case 'C':
+      options->chain = optarg;
+      break;
+    case 'k':
+      options->calibrate = true;
+      break;
+    case 'A':
+      exit_code += process_double(optarg, "alpha", &options->epilogue.alpha);
+      options->use_epilogue = true;
+      break;
+    case 'B':
+      exit_code += process_double(optarg, "beta", &options->epilogue.beta);
+      options->use_epilogue = true;
+      break;
+    case 'b':
+      options->bias = true;
+      options->use_epilogue = true;
+      break;
+    case 'a':
+      exit_code += process_activation(optarg, &options->epilogue);
+      options->use_epilogue = true;
+      break;
+    case 'G':
+      exit_code += process_grid(optarg, options->grid);
+      break;
+    case 'P':
+      if (parse_cpu_list(optarg, &options->cpus) != 0) {
+        fprintf(stderr, "Error: Invalid cpus '%s'\n", optarg);
+        exit_code += EXIT_FAILURE;
+      }
+      break;
+    case 'T':
+      options->latency = true;
+      break;
+    case 'K':
+      exit_code += process_count(optarg, "throughput", &options->throughput);
+      break;
+    case 'R':
+      exit_code += process_count(optarg, "repeat", &options->repeat);
+      break;
+    case 'e':
+      exit_code += process_seed(optarg, &options->generator.seed);
+      break;
+    case 'g':
+      exit_code +=
+          process_distribution(optarg, &options->generator.distribution);
+      options->random = true;
+      break;
+    case 'E':
+      options->energy = true;
+      break;
+    case 't':
+#ifdef DGEMM_TRACE
+      options->trace = optarg;
+#else
+      fprintf(stderr, "Error: Binary does not include tracing\n");
+      exit_code += EXIT_FAILURE;
+#endif
+      break;
+    case 'M':
+      exit_code += process_count(optarg, "prepacked", &options->prepacked);
+      break;
+    case 'H':
+      options->physical_cores = true;
+      break;
+    case 'I':
+      options->topology = true;
+      break;
+    case 'V':
+      options->level2 = true;
+      break;
+    case 'W':
+      exit_code += process_scaling(optarg, &options->scaling);
+      break;
+    case 'U':
+      exit_code +=
+          process_density(optarg, "incremental", options->incremental);
       break;
     case 'h':
       help = true;
@@ -211,25 +482,53 @@ void parse_options(int argc, char *argv[], bool dgemms[], int *length,
     }
   }
 
-  if ((!is_set_length && loop[0] == 0) || !is_set_dgemms || exit_code || help) {
+  if (options->server == NULL && options->chain == NULL &&
+      !options->topology &&
+      ((!is_set_length && options->loop[0] == 0) ||
+       (!is_set_dgemms && options->grid[0] == 0 && !options->level2))) {
+    help = true;
+  }
+
+  if (!options->random)
+    options->generator.distribution = distribution_index;
+
+  if (options->cpus.count == 0 && allowed_cpu_list(&options->cpus) != 0) {
+    perror("Error: sched_getaffinity");
+    exit_code += EXIT_FAILURE;
+  }
+
+  if (options->physical_cores && options->cpus.count > 0) {
+    topology topology;
+
+    discover_topology(&options->cpus, &topology);
+    physical_cores(&topology, &options->cpus);
+    free_topology(&topology);
+  }
+
+  if (options->throughput > options->cpus.count) {
+    fprintf(stderr, "Error: Throughput %d needs %d cpus, got %d\n",
+            options->throughput, options->throughput, options->cpus.count);
+    exit_code += EXIT_FAILURE;
+  }
+
+  if (exit_code || help) {
     print_help();
     exit(exit_code > 0);
   }
 }
 
-void generate_matrices(int length, double *a, double *b, bool random) {
-  srand(time(NULL));
+void generate_matrices(generator *generator, int length, double *a,
+                       double *b) {
+  generate_matrix(generator, stream_a, length, length, a);
+  generate_matrix(generator, stream_b, length, length, b);
+}
 
-  if (random) {
-    for (int index = 0; index < length * length; index++) {
-      a[index] = (double)4 * rand() / RAND_MAX;
-      b[index] = (double)4 * rand() / RAND_MAX;
-    }
-  } else {
-    for (int index = 0; index < length * length; index++) {
-      a[index] = index;
-      b[index] = index;
-    }
+void sparsify_matrix(generator *generator, int length, double *a,
+                     double density) {
+#pragma omp parallel for
+  for (int index = 0; index < length * length; index++) {
+    if (generator_uniform(generator, stream_mask, index) >= density)
+      a[index] = 0;
   }
 }
 
@@ -257,168 +556,45 @@ void print_result(dgemm dgemm, int length, double seconds) {
          gflops / seconds);
 }
 
-void copy_to_big_matrix(int old_length, int new_length, double *old_a,
-                        double *new_a, double *old_b, double *new_b,
-                        double *old_c, double *new_c) {
+double max_error(int length, double *c, double *reference) {
+  double error = 0;
 
-  int i = 0;
-  for (; i < old_length; i++) {
-    int j = 0;
-    int io = i * old_length;
-    int in = i * new_length;
-    for (; j < old_length; j++) {
-      new_a[j + in] = old_a[j + io];
-      new_b[j + in] = old_b[j + io];
-      new_c[j + in] = old_c[j + io];
-    }
-    for (; j < new_length; j++) {
-      new_a[j + in] = 0;
-      new_b[j + in] = 0;
-      new_c[j + in] = 0;
-    }
-  }
-  for (; i < new_length; i++) {
-    int in = i * new_length;
-    for (int j = 0; j < new_length; j++) {
-      new_a[j + in] = 0;
-      new_b[j + in] = 0;
-      new_c[j + in] = 0;
-    }
+  for (int index = 0; index < length * length; index++) {
+    double expected = fabs(reference[index]) > 1 ? fabs(reference[index]) : 1;
+    double diff = fabs(c[index] - reference[index]) / expected;
+    error = diff > error ? diff : error;
   }
-}
 
-void copy_to_small_matrix(int big_length, int small_length, double *big,
-                          double *small) {
-  for (int i = 0; i < small_length; i++) {
-    int j = 0;
-    int is = i * small_length;
-    int ib = i * big_length;
-    for (; j < small_length; j++) {
-      small[j + is] = big[j + ib];
-    }
-  }
+  return error;
 }
 
-void multiply(dgemm dgemm, int length, double *a, double *b, double *c) {
-  int new_length = length;
-  double *new_a, *new_b, *new_c;
-  int factor;
-
-  switch (dgemm) {
-  case avx256:
-  case avx256_unroll:
-    factor = AVX256_QT_DOUBLE;
-    break;
-  case avx512:
-  case avx512_unroll:
-    factor = AVX512_QT_DOUBLE;
-    break;
-  case simple_unroll_blocking:
-  case transpose_unroll_blocking:
-  case simd_manual_unroll_blocking:
-  case avx256_unroll_blocking:
-  case avx512_unroll_blocking:
-  case simple_unroll_blocking_parallel:
-  case transpose_unroll_blocking_parallel:
-  case simd_manual_unroll_blocking_parallel:
-  case avx256_unroll_blocking_parallel:
-  case avx512_unroll_blocking_parallel:
-  case perfect:
-    factor = BLOCK_SIZE;
-    break;
-  default:
-    factor = 1;
-  }
-
-  if (length % factor) {
-    new_length += (factor - length % factor);
+void report_result(dgemm dgemm, int length, double seconds, double *c,
+                   double *reference, double reference_seconds,
+                   energy_reading *energy) {
+  double mseconds = seconds * 1000;
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+  char line[256];
+  int size = snprintf(line, sizeof(line), "%s,%d,%.0f,%.2f",
+                      dgemm_names[dgemm], length, mseconds, gflops / seconds);
 
-    new_a = aligned_alloc(ALIGN, new_length * new_length * sizeof(double));
-    new_b = aligned_alloc(ALIGN, new_length * new_length * sizeof(double));
-    new_c = aligned_alloc(ALIGN, new_length * new_length * sizeof(double));
+  if (reference != NULL)
+    size += snprintf(line + size, sizeof(line) - size, ",%.2f",
+                     reference_seconds / seconds);
 
-    copy_to_big_matrix(length, new_length, a, new_a, b, new_b, c, new_c);
+  if (energy != NULL)
+    size += snprintf(line + size, sizeof(line) - size, ",%.3f,%.2f,%.2f,%.3f",
+                     energy->joules, energy->watts, energy->ghz,
+                     gflops / seconds / energy->watts);
 
-  } else {
-    new_a = a;
-    new_b = b;
-    new_c = c;
-  }
+  printf("%s\n", line);
 
-  switch (dgemm) {
-  case DGEMM_COUNT:
+  if (reference == NULL)
     return;
-  case simple:
-    dgemm_simple(new_length, new_a, new_b, new_c);
-    break;
-  case transpose:
-    dgemm_transpose(new_length, new_a, new_b, new_c);
-    break;
-  case simd_manual:
-    dgemm_simd_manual(new_length, new_a, new_b, new_c);
-    break;
-  case avx256:
-    dgemm_avx256(new_length, new_a, new_b, new_c);
-    break;
-  case avx512:
-    dgemm_avx512(new_length, new_a, new_b, new_c);
-    break;
-  case simple_unroll:
-    dgemm_simple_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case transpose_unroll:
-    dgemm_transpose_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case simd_manual_unroll:
-    dgemm_simd_manual_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case avx256_unroll:
-    dgemm_avx256_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case avx512_unroll:
-    dgemm_avx512_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case simple_unroll_blocking:
-    dgemm_simple_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case transpose_unroll_blocking:
-    dgemm_transpose_unroll(new_length, new_a, new_b, new_c);
-    break;
-  case simd_manual_unroll_blocking:
-    dgemm_simd_manual_unroll_blocking(new_length, new_a, new_b, new_c);
-    break;
-  case avx256_unroll_blocking:
-    dgemm_avx256_unroll_blocking(new_length, new_a, new_b, new_c);
-    break;
-  case avx512_unroll_blocking:
-    dgemm_avx512_unroll_blocking(new_length, new_a, new_b, new_c);
-    break;
-  case simple_unroll_blocking_parallel:
-    dgemm_simple_unroll_blocking_parallel(new_length, new_a, new_b, new_c);
-    break;
-  case transpose_unroll_blocking_parallel:
-    dgemm_transpose_unroll_blocking_parallel(new_length, new_a, new_b, new_c);
-    break;
-  case simd_manual_unroll_blocking_parallel:
-    dgemm_simd_manual_unroll_blocking_parallel(new_length, new_a, new_b, new_c);
-    break;
-  case avx256_unroll_blocking_parallel:
-    dgemm_avx256_unroll_blocking_parallel(new_length, new_a, new_b, new_c);
-    break;
-  case avx512_unroll_blocking_parallel:
-    dgemm_avx512_unroll_blocking_parallel(new_length, new_a, new_b, new_c);
-    break;
-  case perfect:
-    dgemm_perfect(new_length, new_a, new_b, new_c);
-  }
-
-  if (length % factor) {
-    copy_to_small_matrix(new_length, length, new_c, c);
 
-    free(new_a);
-    free(new_b);
-    free(new_c);
-  }
+  double error = max_error(length, c, reference);
+  if (error > 1e-9)
+    fprintf(stderr, "Error: %s differs from cblas (%g)\n", dgemm_names[dgemm],
+            error);
 }
 
 int checkAVXOrAVX2Support() {
@@ -449,12 +625,6 @@ void check_avx(bool dgemms[DGEMM_COUNT]) {
     fprintf(stderr, "Error: Binary use AVX256\n");
     exit(EXIT_FAILURE);
   }
-#else
-  if (dgemms[avx256] || dgemms[avx256_unroll] ||
-      dgemms[avx256_unroll_blocking]) {
-    fprintf(stderr, "Error: Binary does not include AVX256\n");
-    exit(EXIT_FAILURE);
-  }
 #endif
 
 #if __AVX512F__
@@ -462,44 +632,83 @@ void check_avx(bool dgemms[DGEMM_COUNT]) {
     fprintf(stderr, "Error: Binary use AVX512\n");
     exit(EXIT_FAILURE);
   }
-#else
-  if (dgemms[avx512] || dgemms[avx512_unroll] ||
-      dgemms[avx512_unroll_blocking]) {
-    fprintf(stderr, "Error: Binary does not include AVX512\n");
-    exit(EXIT_FAILURE);
-  }
 #endif
+
+  for (int i = 0; i < DGEMM_COUNT; i++) {
+    if (dgemms[i] && !dgemm_supported(i)) {
+      fprintf(stderr, "Error: Binary does not include %s\n", dgemm_names[i]);
+      exit(EXIT_FAILURE);
+    }
+  }
 }
 
-void run_dgemm(bool dgemms[DGEMM_COUNT], int length, bool random,
-               bool show_result, bool show_matrices, bool parallel) {
+void run_dgemm(bool dgemms[DGEMM_COUNT], int length, generator *generator,
+               bool show_result, bool show_matrices, bool parallel,
+               dgemm_epilogue *epilogue, bool bias, energy_meter *meter) {
   double *a = aligned_alloc(ALIGN, length * length * sizeof(double));
   double *b = aligned_alloc(ALIGN, length * length * sizeof(double));
+  dgemm_epilogue length_epilogue;
+
+  generate_matrices(generator, length, a, b);
 
-  generate_matrices(length, a, b, random);
+  if (epilogue != NULL) {
+    length_epilogue = *epilogue;
+    epilogue = &length_epilogue;
+
+    if (bias) {
+      epilogue->bias = malloc(length * sizeof(double));
+
+      for (int index = 0; index < length; index++)
+        epilogue->bias[index] =
+            generator->distribution == distribution_index
+                ? index
+                : 4 * generator_uniform(generator, stream_bias, index) - 2;
+    }
+  }
 
   if (show_matrices) {
     print_matrix(length, a);
     print_matrix(length, b);
   }
 
+  double *reference = NULL, reference_seconds = 0;
+
+#ifdef USE_CBLAS
+  reference = aligned_alloc(ALIGN, length * length * sizeof(double));
+  clean_matrix(length, reference);
+  multiply_epilogue(cblas, length, a, b, reference, epilogue);
+  clean_matrix(length, reference);
+
+  double reference_start = omp_get_wtime();
+  multiply_epilogue(cblas, length, a, b, reference, epilogue);
+  reference_seconds = omp_get_wtime() - reference_start;
+#endif
+
   int i = 0;
 
-#pragma omp parallel for if (parallel)
+#pragma omp parallel for if (parallel && meter == NULL)
   for (i = 0; i < simple_unroll_blocking_parallel; i++) {
     if (dgemms[i]) {
       double *c = aligned_alloc(ALIGN, length * length * sizeof(double));
+      energy_reading energy;
 
       clean_matrix(length, c);
 
+      if (meter != NULL)
+        start_energy_meter(meter);
+
       double start_time = omp_get_wtime();
-      multiply(i, length, a, b, c);
+      multiply_epilogue(i, length, a, b, c, epilogue);
       double diff = omp_get_wtime() - start_time;
 
+      if (meter != NULL)
+        stop_energy_meter(meter, diff, &energy);
+
       if (show_result)
         print_matrix(length, c);
 
-      print_result(i, length, diff);
+      report_result(i, length, diff, c, reference, reference_seconds,
+                    meter != NULL ? &energy : NULL);
 
       free(c);
     }
@@ -509,54 +718,986 @@ void run_dgemm(bool dgemms[DGEMM_COUNT], int length, bool random,
 
   for (i = simple_unroll_blocking_parallel; i < DGEMM_COUNT; i++) {
     if (dgemms[i]) {
+      energy_reading energy;
 
       clean_matrix(length, c);
 
+      if (meter != NULL)
+        start_energy_meter(meter);
+
       double start_time = omp_get_wtime();
-      multiply(i, length, a, b, c);
+      multiply_epilogue(i, length, a, b, c, epilogue);
       double diff = omp_get_wtime() - start_time;
 
+      if (meter != NULL)
+        stop_energy_meter(meter, diff, &energy);
+
       if (show_result)
         print_matrix(length, c);
 
-      print_result(i, length, diff);
+      report_result(i, length, diff, c, reference, reference_seconds,
+                    meter != NULL ? &energy : NULL);
     }
   }
 
+  if (epilogue != NULL)
+    free(epilogue->bias);
+
+  free(reference);
   free(a);
   free(b);
   free(c);
 }
 
-int main(int argc, char *argv[]) {
-  bool dgemms[DGEMM_COUNT];
-  int loop[3] = {0, 0, 0};
-  int length = 0;
-  bool random = false, show_result = false, show_matrices = false,
-       parallel = false;
+void run_density_sweep(bool dgemms[DGEMM_COUNT], int length,
+                       generator *generator, double density[3]) {
+  double *a = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *b = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *c = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *sparse = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *reference = aligned_alloc(ALIGN, length * length * sizeof(double));
+  dgemm reference_dgemm = DGEMM_COUNT;
+
+  double dense_seconds[DGEMM_COUNT];
+  double crossover[2][DGEMM_COUNT];
+  const char *sparse_names[2] = {"csr", "csr_parallel"};
+
+  generate_matrices(generator, length, a, b);
 
   for (int i = 0; i < DGEMM_COUNT; i++) {
-    dgemms[i] = false;
+    crossover[0][i] = 0;
+    crossover[1][i] = 0;
+
+    if (dgemms[i]) {
+      clean_matrix(length, c);
+
+      double start_time = omp_get_wtime();
+      multiply(i, length, a, b, c);
+      dense_seconds[i] = omp_get_wtime() - start_time;
+
+      print_result(i, length, dense_seconds[i]);
+
+      if (reference_dgemm == DGEMM_COUNT)
+        reference_dgemm = i;
+    }
   }
 
-  parse_options(argc, argv, dgemms, &length, loop, &random, &show_result,
-                &show_matrices, &parallel);
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
 
-  check_avx(dgemms);
+  for (double d = density[0]; d <= density[1] + DBL_EPSILON; d += density[2]) {
+    memcpy(sparse, a, length * length * sizeof(double));
+    sparsify_matrix(generator, length, sparse, d);
+    csr_matrix *csr = csr_from_dense(length, sparse);
 
-  if (loop[0] == 0) {
-    run_dgemm(dgemms, length, random, show_result, show_matrices, parallel);
-  } else {
-    if (length > 0) {
-      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
-        run_dgemm(dgemms, length, random, show_result, show_matrices, parallel);
-      }
-    } else {
-      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
-        run_dgemm(dgemms, i, random, show_result, show_matrices, parallel);
+    if (reference_dgemm != DGEMM_COUNT) {
+      clean_matrix(length, reference);
+      multiply(reference_dgemm, length, sparse, b, reference);
+    }
+
+    for (int s = 0; s < 2; s++) {
+      clean_matrix(length, c);
+
+      double start_time = omp_get_wtime();
+      if (s == 0)
+        spmm_csr(csr, b, c);
+      else
+        spmm_csr_parallel(csr, b, c);
+      double diff = omp_get_wtime() - start_time;
+
+      printf("%s,%d,%.0f,%.2f,%.4f\n", sparse_names[s], length, diff * 1000,
+             gflops / diff, (double)csr->nnz / ((double)length * length));
+
+      if (reference_dgemm != DGEMM_COUNT) {
+        double error = max_error(length, c, reference);
+        if (error > 1e-9)
+          fprintf(stderr, "Error: %s differs from %s (%g)\n", sparse_names[s],
+                  dgemm_names[reference_dgemm], error);
       }
+
+      for (int i = 0; i < DGEMM_COUNT; i++)
+        if (dgemms[i] && diff < dense_seconds[i])
+          crossover[s][i] = d;
     }
+
+    csr_free(csr);
+  }
+
+  for (int s = 0; s < 2; s++)
+    for (int i = 0; i < DGEMM_COUNT; i++)
+      if (dgemms[i])
+        printf("crossover,%s,%s,%d,%.4f\n", sparse_names[s], dgemm_names[i],
+               length, crossover[s][i]);
+
+  free(a);
+  free(b);
+  free(c);
+  free(sparse);
+  free(reference);
+}
+
+double *read_matrix_file(const char *path, int *rows, int *columns) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open matrix '%s'\n", path);
+    return NULL;
+  }
+
+  if (fscanf(file, "%d %d", rows, columns) != 2 || *rows <= 0 ||
+      *columns <= 0) {
+    fprintf(stderr, "Error: Invalid matrix '%s'\n", path);
+    fclose(file);
+    return NULL;
   }
 
+  size_t size = (size_t)*rows * *columns;
+  double *matrix = aligned_alloc(ALIGN, size * sizeof(double));
+
+  for (size_t index = 0; index < size; index++) {
+    if (fscanf(file, "%lf", &matrix[index]) != 1) {
+      fprintf(stderr, "Error: Invalid matrix '%s'\n", path);
+      free(matrix);
+      fclose(file);
+      return NULL;
+    }
+  }
+
+  fclose(file);
+
+  return matrix;
+}
+
+void run_chain_plan(chain_plan *plan, const char *name, double **matrices,
+                    double *result) {
+  char *parenthesization = malloc(plan->count * 16);
+  chain_parenthesization(plan, parenthesization);
+
+  double flops = chain_flops(plan);
+  int rows = plan->dims[0], columns = plan->dims[plan->count];
+
+  memset(result, 0, (size_t)rows * columns * sizeof(double));
+
+  double start_time = omp_get_wtime();
+  chain_multiply(plan, matrices, result);
+  double diff = omp_get_wtime() - start_time;
+
+  printf("%s,%d,%.0f,%.2f,%.3f,%s\n", name, plan->count, diff * 1000,
+         flops / diff / pow(10, 9), flops / pow(10, 9), parenthesization);
+
+  free(parenthesization);
+}
+
+int run_chain(options *options) {
+  int count = 1;
+  for (char *c = options->chain; *c != '\0'; c++)
+    count += *c == ',';
+
+  int *rows = malloc(count * sizeof(int));
+  int *columns = malloc(count * sizeof(int));
+  int *dims = malloc((count + 1) * sizeof(int));
+  double **matrices = calloc(count, sizeof(double *));
+  int exit_code = EXIT_SUCCESS;
+
+  char *token = strtok(options->chain, ",");
+  for (int i = 0; i < count && exit_code == EXIT_SUCCESS; i++) {
+    char end;
+
+    if (token == NULL) {
+      fprintf(stderr, "Error: Invalid chain\n");
+      exit_code = EXIT_FAILURE;
+    } else if (sscanf(token, "%dx%d%c", &rows[i], &columns[i], &end) == 2) {
+      if (rows[i] <= 0 || columns[i] <= 0) {
+        fprintf(stderr, "Error: Invalid shape '%s'\n", token);
+        exit_code = EXIT_FAILURE;
+      }
+    } else {
+      matrices[i] = read_matrix_file(token, &rows[i], &columns[i]);
+      if (matrices[i] == NULL)
+        exit_code = EXIT_FAILURE;
+    }
+
+    if (exit_code == EXIT_SUCCESS && i > 0 && rows[i] != columns[i - 1]) {
+      fprintf(stderr, "Error: Shape mismatch between A%d and A%d\n", i, i + 1);
+      exit_code = EXIT_FAILURE;
+    }
+
+    token = strtok(NULL, ",");
+  }
+
+  if (exit_code == EXIT_SUCCESS && count < 2) {
+    fprintf(stderr, "Error: Chain needs at least two matrices\n");
+    exit_code = EXIT_FAILURE;
+  }
+
+  if (exit_code == EXIT_SUCCESS) {
+    dims[0] = rows[0];
+    for (int i = 0; i < count; i++) {
+      dims[i + 1] = columns[i];
+
+      if (matrices[i] == NULL) {
+        size_t size = (size_t)rows[i] * columns[i];
+        matrices[i] = aligned_alloc(ALIGN, size * sizeof(double));
+
+        if (options->random) {
+          generate_matrix(&options->generator, stream_chain + i, rows[i],
+                          columns[i], matrices[i]);
+        } else {
+          for (size_t index = 0; index < size; index++)
+            matrices[i][index] = index % 4;
+        }
+      }
+    }
+
+    chain_calibration calibration;
+    if (options->calibrate)
+      calibrate_chain(&calibration);
+
+    chain_plan *naive = plan_chain_naive(count, dims);
+    chain_plan *optimal =
+        plan_chain(count, dims, options->calibrate ? &calibration : NULL);
+    double *result = aligned_alloc(
+        ALIGN, (size_t)dims[0] * dims[count] * sizeof(double) + ALIGN);
+
+    run_chain_plan(naive, "chain_naive", matrices, result);
+    run_chain_plan(optimal, "chain_optimal", matrices, result);
+
+    if (options->show_result) {
+      for (int i = 0; i < dims[0]; i++) {
+        printf("| ");
+        for (int j = 0; j < dims[count]; j++)
+          printf("%06.2f ", result[i + j * dims[0]]);
+        printf("|\n");
+      }
+    }
+
+    free(result);
+    free_chain_plan(naive);
+    free_chain_plan(optimal);
+  }
+
+  for (int i = 0; i < count; i++)
+    free(matrices[i]);
+
+  free(matrices);
+  free(rows);
+  free(columns);
+  free(dims);
+
+  return exit_code;
+}
+
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+void run_load(options *options, dgemm dgemm) {
+  int length = options->length;
+  int clients = options->clients;
+  int requests = options->requests;
+  double *latencies = malloc(clients * requests * sizeof(double));
+  int completed = 0;
+
+  double start_time = omp_get_wtime();
+
+#pragma omp parallel num_threads(clients) reduction(+ : completed)
+  {
+    int id = omp_get_thread_num();
+    double *latency = latencies + id * requests;
+    dgemm_client client;
+
+    int status = dgemm_client_connect(&client, options->load, length);
+
+    if (status != 0) {
+      fprintf(stderr, "Error: Could not connect to '%s': %s\n", options->load,
+              strerror(status));
+    } else {
+      double *a = dgemm_client_matrix(&client, 0);
+      double *b = dgemm_client_matrix(&client, 1);
+      double *c = dgemm_client_matrix(&client, 2);
+
+      generate_matrices(&options->generator, length, a, b);
+
+      for (int r = 0; r < requests; r++) {
+        double request_time = omp_get_wtime();
+        status = dgemm_client_multiply(&client, dgemm, a, b, c, true, NULL);
+
+        if (status != 0) {
+          fprintf(stderr, "Error: Request failed: %s\n", strerror(status));
+          break;
+        }
+
+        latency[completed++] = omp_get_wtime() - request_time;
+      }
+
+      dgemm_client_close(&client);
+    }
+
+    for (int r = completed; r < requests; r++)
+      latency[r] = DBL_MAX;
+  }
+
+  double diff = omp_get_wtime() - start_time;
+
+  qsort(latencies, clients * requests, sizeof(double), compare_doubles);
+
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+  double p50 = completed ? latencies[(completed - 1) / 2] : 0;
+  double p99 = completed ? latencies[(int)((completed - 1) * 0.99)] : 0;
+
+  printf("load,%s,%d,%d,%.2f,%.2f,%.3f,%.3f\n", dgemm_names[dgemm], length,
+         clients, completed / diff, gflops * completed / diff, p50 * 1000,
+         p99 * 1000);
+
+  free(latencies);
+}
+
+int team_size(dgemm dgemm, int length) {
+  int threads = dgemm_threads(length) > 0 ? dgemm_threads(length) : 1;
+
+  if (dgemm < simple_unroll_blocking_parallel)
+    return 1;
+
+  if (dgemm == pipelined)
+    return threads + 1;
+
+  if (dgemm == morton || dgemm == balanced)
+    return omp_get_max_threads();
+
+  return threads;
+}
+
+void run_latency(options *options, dgemm dgemm, int length) {
+  int repeat = options->repeat;
+  double *a = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *b = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *c = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *latencies = malloc(repeat * sizeof(double));
+  int threads = team_size(dgemm, length);
+  cpu_list saved = {0, NULL};
+
+  generate_matrices(&options->generator, length, a, b);
+
+  allowed_cpu_list(&saved);
+
+  if (threads > 1)
+    pin_omp_threads(&options->cpus, threads);
+  else
+    pin_thread(options->cpus.cpus[0]);
+
+  clean_matrix(length, c);
+  multiply(dgemm, length, a, b, c);
+
+  for (int r = 0; r < repeat; r++) {
+    clean_matrix(length, c);
+
+    double start_time = omp_get_wtime();
+    multiply(dgemm, length, a, b, c);
+    latencies[r] = omp_get_wtime() - start_time;
+  }
+
+  qsort(latencies, repeat, sizeof(double), compare_doubles);
+
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+  double p50 = latencies[(repeat - 1) / 2];
+  double p99 = latencies[(int)((repeat - 1) * 0.99)];
+
+  printf("latency,%s,%d,%d,%.3f,%.2f,%.3f,%.3f\n", dgemm_names[dgemm], length,
+         threads, p50 * 1000, gflops / p50, latencies[0] * 1000, p99 * 1000);
+
+  if (threads > 1)
+    restore_omp_threads(&saved, threads);
+  else
+    restore_thread(&saved);
+  free_cpu_list(&saved);
+
+  free(a);
+  free(b);
+  free(c);
+  free(latencies);
+}
+
+void run_throughput(options *options, dgemm dgemm, int length) {
+  int instances = options->throughput;
+  int repeat = options->repeat;
+  double *latencies = malloc(instances * repeat * sizeof(double));
+  double *a = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *b = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double start_time = 0, diff = 0;
+
+  cpu_list saved = {0, NULL};
+
+  generate_matrices(&options->generator, length, a, b);
+  allowed_cpu_list(&saved);
+
+  int levels = omp_get_max_active_levels();
+  omp_set_max_active_levels(1);
+
+#pragma omp parallel num_threads(instances)
+  {
+    int id = omp_get_thread_num();
+    double *latency = latencies + id * repeat;
+
+    pin_thread(options->cpus.cpus[id]);
+
+    double *local_a = aligned_alloc(ALIGN, length * length * sizeof(double));
+    double *local_b = aligned_alloc(ALIGN, length * length * sizeof(double));
+    double *c = aligned_alloc(ALIGN, length * length * sizeof(double));
+
+    memcpy(local_a, a, length * length * sizeof(double));
+    memcpy(local_b, b, length * length * sizeof(double));
+    clean_matrix(length, c);
+    multiply(dgemm, length, local_a, local_b, c);
+
+#pragma omp barrier
+#pragma omp single
+    start_time = omp_get_wtime();
+
+    for (int r = 0; r < repeat; r++) {
+      clean_matrix(length, c);
+
+      double request_time = omp_get_wtime();
+      multiply(dgemm, length, local_a, local_b, c);
+      latency[r] = omp_get_wtime() - request_time;
+    }
+
+#pragma omp barrier
+#pragma omp single
+    diff = omp_get_wtime() - start_time;
+
+    free(local_a);
+    free(local_b);
+    free(c);
+    restore_thread(&saved);
+  }
+
+  omp_set_max_active_levels(levels);
+  free_cpu_list(&saved);
+
+  int count = instances * repeat;
+  qsort(latencies, count, sizeof(double), compare_doubles);
+
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+  double p50 = latencies[(count - 1) / 2];
+  double p99 = latencies[(int)((count - 1) * 0.99)];
+
+  printf("throughput,%s,%d,%d,%.2f,%.3f,%.3f\n", dgemm_names[dgemm], length,
+         instances, gflops * count / diff, p50 * 1000, p99 * 1000);
+
+  free(a);
+  free(b);
+  free(latencies);
+}
+
+void run_pinned(options *options, int length) {
+  for (int i = 0; i < DGEMM_COUNT; i++) {
+    if (!options->dgemms[i])
+      continue;
+
+    if (options->latency)
+      run_latency(options, i, length);
+
+    if (options->throughput > 0)
+      run_throughput(options, i, length);
+  }
+}
+
+void run_prepacked(options *options, int length) {
+  int multiplies = options->prepacked;
+  size_t size = (size_t)length * length * sizeof(double);
+  double *a = aligned_alloc(ALIGN, size);
+  double *b = aligned_alloc(ALIGN, size);
+  double *c = aligned_alloc(ALIGN, size);
+  double *reference = NULL;
+  dgemm reference_dgemm = 0;
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+
+  generate_matrices(&options->generator, length, a, b);
+
+  for (int i = 0; i < DGEMM_COUNT; i++) {
+    if (!options->dgemms[i])
+      continue;
+
+    double seconds = 0;
+
+    clean_matrix(length, c);
+    multiply(i, length, a, b, c);
+
+    for (int m = 0; m < multiplies; m++) {
+      clean_matrix(length, c);
+
+      double start_time = omp_get_wtime();
+      multiply(i, length, a, b, c);
+      seconds += omp_get_wtime() - start_time;
+    }
+
+    printf("prepacked,%s,%d,%d,%.3f,%.3f,%.2f\n", dgemm_names[i], length,
+           multiplies, 0.0, seconds * 1000 / multiplies,
+           gflops * multiplies / seconds);
+
+    if (reference == NULL) {
+      reference = c;
+      reference_dgemm = i;
+      c = aligned_alloc(ALIGN, size);
+    }
+  }
+
+  double start_time = omp_get_wtime();
+  packed_matrix *packed = pack_matrix(length, b);
+  double pack_seconds = omp_get_wtime() - start_time;
+  double seconds = pack_seconds;
+
+  clean_matrix(length, c);
+  multiply_packed(a, packed, c);
+
+  for (int m = 0; m < multiplies; m++) {
+    clean_matrix(length, c);
+
+    double start_time = omp_get_wtime();
+    multiply_packed(a, packed, c);
+    seconds += omp_get_wtime() - start_time;
+  }
+
+  printf("prepacked,packed,%d,%d,%.3f,%.3f,%.2f\n", length, multiplies,
+         pack_seconds * 1000, seconds * 1000 / multiplies,
+         gflops * multiplies / seconds);
+
+  if (reference != NULL) {
+    double error = max_error(length, c, reference);
+    if (error > 1e-9)
+      fprintf(stderr, "Error: packed differs from %s (%g)\n",
+              dgemm_names[reference_dgemm], error);
+  }
+
+  free_packed_matrix(packed);
+  free(a);
+  free(b);
+  free(c);
+  free(reference);
+}
+
+void run_incremental(options *options, int length) {
+  double *fraction = options->incremental;
+  size_t size = (size_t)length * length * sizeof(double);
+  double *a = aligned_alloc(ALIGN, size);
+  double *b = aligned_alloc(ALIGN, size);
+  double *c = aligned_alloc(ALIGN, size);
+  double *reference = aligned_alloc(ALIGN, size);
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+  const char *tracker_names[2] = {"explicit", "checksum"};
+
+  generate_matrices(&options->generator, length, a, b);
+
+  incremental *trackers[2] = {create_incremental(length, a, b),
+                              create_incremental(length, a, b)};
+
+  for (double f = fraction[0]; f <= fraction[1] + DBL_EPSILON;
+       f += fraction[2]) {
+    int count = (int)ceil(f * length);
+    int start = (length - count) / 2;
+    double full_seconds = 0;
+    dgemm reference_dgemm = DGEMM_COUNT;
+
+    for (int j = start; j < start + count; j++)
+      for (int i = 0; i < length; i++)
+        a[i + (size_t)j * length] += 1;
+
+    for (int j = 0; j < length; j++)
+      for (int k = start; k < start + count; k++)
+        b[k + (size_t)j * length] += 1;
+
+    for (int i = 0; i < DGEMM_COUNT; i++) {
+      if (!options->dgemms[i])
+        continue;
+
+      double *result = reference_dgemm == DGEMM_COUNT ? reference : c;
+      clean_matrix(length, result);
+
+      double start_time = omp_get_wtime();
+      multiply(i, length, a, b, result);
+      double seconds = omp_get_wtime() - start_time;
+
+      if (reference_dgemm == DGEMM_COUNT) {
+        reference_dgemm = i;
+        full_seconds = seconds;
+      }
+
+      printf("incremental,%s,%d,%.4f,%.4f,%.3f,%.2f,%.2f\n", dgemm_names[i],
+             length, f, 1.0, seconds * 1000, gflops / seconds,
+             full_seconds / seconds);
+    }
+
+    for (int t = 0; t < 2; t++) {
+      double start_time = omp_get_wtime();
+
+      if (t == 0) {
+        mark_dirty(trackers[t], operand_a, 0, start, length, count);
+        mark_dirty(trackers[t], operand_b, start, 0, count, length);
+      } else {
+        scan_dirty(trackers[t]);
+      }
+
+      double work = update_incremental(trackers[t], c);
+      double seconds = omp_get_wtime() - start_time;
+
+      printf("incremental,%s,%d,%.4f,%.4f,%.3f,%.2f,%.2f\n", tracker_names[t],
+             length, f, work, seconds * 1000, gflops / seconds,
+             full_seconds / seconds);
+
+      if (reference_dgemm == DGEMM_COUNT)
+        continue;
+
+      double error = max_error(length, c, reference);
+      if (error > 1e-9)
+        fprintf(stderr, "Error: %s differs from %s (%g)\n", tracker_names[t],
+                dgemm_names[reference_dgemm], error);
+    }
+  }
+
+  free_incremental(trackers[0]);
+  free_incremental(trackers[1]);
+  free(a);
+  free(b);
+  free(c);
+  free(reference);
+}
+
+void run_scaling(options *options, dgemm dgemm, int length) {
+  int repeat = options->repeat;
+  double *latencies = malloc(repeat * sizeof(double));
+  double base_gflops = 0;
+  cpu_list cpus = options->cpus;
+
+  for (int threads = 1; threads <= options->cpus.count; threads++) {
+    int size = options->scaling == scaling_weak
+                   ? (int)llround(length * cbrt(threads))
+                   : length;
+    size_t bytes = (size_t)size * size * sizeof(double);
+
+    cpus.count = threads;
+    pin_omp_threads(&cpus, dgemm == pipelined ? threads + 1 : threads);
+    omp_set_num_threads(threads);
+    set_dgemm_threads(threads);
+
+    if (dgemm == balanced) {
+      topology topology;
+
+      discover_topology(&cpus, &topology);
+      measure_speed(&topology);
+      set_placement(&topology);
+      free_topology(&topology);
+    }
+
+    double bandwidth =
+        measure_bandwidth(2 * BANDWIDTH_LENGTH * sizeof(double), false);
+    double *a = aligned_alloc(ALIGN, bytes);
+    double *b = aligned_alloc(ALIGN, bytes);
+    double *c = aligned_alloc(ALIGN, bytes);
+
+    generate_matrices(&options->generator, size, a, b);
+
+    clean_matrix(size, c);
+    multiply(dgemm, size, a, b, c);
+
+    for (int r = 0; r < repeat; r++) {
+      clean_matrix(size, c);
+
+      double start_time = omp_get_wtime();
+      multiply(dgemm, size, a, b, c);
+      latencies[r] = omp_get_wtime() - start_time;
+    }
+
+    qsort(latencies, repeat, sizeof(double), compare_doubles);
+
+    double p50 = latencies[(repeat - 1) / 2];
+    double gflops = 2 * pow(size, 3) / p50 / pow(10, 9);
+    double traffic = 8 * (2 * pow(size, 3) / BLOCK_SIZE + 2 * pow(size, 2));
+    double gbs = traffic / p50 / pow(10, 9);
+
+    if (threads == 1)
+      base_gflops = gflops;
+
+    double speedup = gflops / base_gflops;
+
+    printf("scaling,%s,%s,%d,%d,%.3f,%.2f,%.2f,%.3f,%.2f,%.2f,%.1f\n",
+           scaling_names[options->scaling], dgemm_names[dgemm], size, threads,
+           p50 * 1000, gflops, speedup, speedup / threads, gbs, bandwidth,
+           100 * gbs / bandwidth);
+
+    free(a);
+    free(b);
+    free(c);
+  }
+
+  set_dgemm_threads(0);
+  free(latencies);
+}
+
+typedef enum {
+  level2_gemv,
+  level2_gemv_transpose,
+  level2_ger,
+  level2_small,
+  level2_rectangular,
+  LEVEL2_COUNT
+} level2_kernel;
+
+const char *level2_names[LEVEL2_COUNT] = {
+    "gemv", "gemv_transpose", "ger", "small", "rectangular",
+};
+
+void run_level2_kernel(level2_kernel kernel, int length, double *a, double *x,
+                       double *y) {
+  switch (kernel) {
+  case level2_gemv:
+    dgemv(false, length, length, a, length, x, 1, y, 1);
+    break;
+  case level2_gemv_transpose:
+    dgemv(true, length, length, a, length, x, 1, y, 1);
+    break;
+  case level2_ger:
+    dger(length, length, x, 1, y, 1, a, length);
+    break;
+  case level2_small:
+    dgemm_small(length, SMALL_PANEL, length, a, length, x, length, y, length);
+    break;
+  case level2_rectangular:
+    dgemm_rectangular(length, SMALL_PANEL, length, a, length, x, length, y,
+                      length);
+    break;
+  case LEVEL2_COUNT:
+    break;
+  }
+}
+
+void run_level2(options *options, int length, double peak) {
+  int repeat = options->repeat;
+  size_t size = (size_t)length * length * sizeof(double);
+  size_t panel = (size_t)length * SMALL_PANEL * sizeof(double);
+  double *a = aligned_alloc(ALIGN, size);
+  double *x = aligned_alloc(ALIGN, panel);
+  double *y = aligned_alloc(ALIGN, panel);
+  double *latencies = malloc(repeat * sizeof(double));
+  double bandwidth[2] = {measure_bandwidth(size + 2 * panel, false),
+                         measure_bandwidth(size, true)};
+  double m = length, n = SMALL_PANEL;
+
+  double flops[LEVEL2_COUNT] = {2 * m * m, 2 * m * m, 2 * m * m, 2 * m * m * n,
+                                2 * m * m * n};
+  double bytes[LEVEL2_COUNT] = {
+      8 * (m * m + 3 * m),         8 * (m * m + 3 * m),
+      8 * (2 * m * m + 2 * m),     8 * (m * m + 3 * m * n),
+      8 * (m * m + 3 * m * n),
+  };
+
+  for (int kernel = 0; kernel < LEVEL2_COUNT; kernel++) {
+    generate_matrix(&options->generator, stream_a, length, length, a);
+    generate_matrix(&options->generator, stream_b, length, SMALL_PANEL, x);
+    memset(y, 0, panel);
+
+    run_level2_kernel(kernel, length, a, x, y);
+
+    for (int r = 0; r < repeat; r++) {
+      double start_time = omp_get_wtime();
+      run_level2_kernel(kernel, length, a, x, y);
+      latencies[r] = omp_get_wtime() - start_time;
+    }
+
+    qsort(latencies, repeat, sizeof(double), compare_doubles);
+
+    double p50 = latencies[(repeat - 1) / 2];
+    double gbs = bytes[kernel] / p50 / pow(10, 9);
+    double intensity = flops[kernel] / bytes[kernel];
+    double ceiling = bandwidth[kernel == level2_ger];
+    double roof = peak / intensity < ceiling ? peak / intensity : ceiling;
+
+    printf("level2,%s,%d,%.3f,%.2f,%.2f,%.2f,%.1f\n", level2_names[kernel],
+           length, p50 * 1000, flops[kernel] / p50 / pow(10, 9), gbs, roof,
+           100 * gbs / roof);
+  }
+
+  free(a);
+  free(x);
+  free(y);
+  free(latencies);
+}
+
+void run_topology(options *options) {
+  topology topology;
+
+  discover_topology(&options->cpus, &topology);
+  measure_speed(&topology);
+
+  for (int i = 0; i < topology.count; i++) {
+    cpu_info *info = &topology.cpus[i];
+
+    printf("topology,%d,%d,%d,%d,%d,%d,%s,%d,%.2f\n", info->cpu, info->package,
+           info->core, info->sibling, info->siblings, info->l2,
+           core_type_names[info->type], info->capacity, info->gflops);
+  }
+
+  free_topology(&topology);
+}
+
+int main(int argc, char *argv[]) {
+  options options = {.clients = 4,
+                     .requests = 100,
+                     .epilogue = {1, 0},
+                     .repeat = 1,
+                     .generator = {.distribution = distribution_uniform}};
+
+  parse_options(argc, argv, &options);
+
+  bool *dgemms = options.dgemms;
+  int *loop = options.loop;
+  int length = options.length;
+  bool show_result = options.show_result,
+       show_matrices = options.show_matrices, parallel = options.parallel;
+  double *density = options.density;
+  dgemm_epilogue *epilogue = options.use_epilogue ? &options.epilogue : NULL;
+  energy_meter energy_meter, *meter = NULL;
+
+  if (options.trace != NULL) {
+    int max_length = loop[0] > 0 && loop[1] > length ? loop[1] : length;
+    trace_init(max_length / BLOCK_SIZE + omp_get_num_procs());
+  }
+
+  bool remote[DGEMM_COUNT] = {false};
+  check_avx(options.load == NULL ? dgemms : remote);
+
+  if (dgemms[balanced]) {
+    topology topology;
+
+    discover_topology(&options.cpus, &topology);
+    measure_speed(&topology);
+    set_placement(&topology);
+    free_topology(&topology);
+  }
+
+  if (options.server != NULL) {
+    return run_server(options.server);
+  } else if (options.chain != NULL) {
+    return run_chain(&options);
+  } else if (options.topology) {
+    run_topology(&options);
+  } else if (options.grid[0] > 0) {
+    int exit_code = EXIT_SUCCESS;
+
+#ifdef USE_MPI
+    MPI_Init(NULL, NULL);
+#endif
+
+    if (loop[0] == 0) {
+      exit_code = run_summa(options.grid[0], options.grid[1], length,
+                            &options.generator);
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        exit_code += run_summa(options.grid[0], options.grid[1],
+                               length > 0 ? length : i, &options.generator);
+      }
+    }
+
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+
+    return exit_code > 0;
+  } else if (options.load != NULL) {
+    for (int i = 0; i < DGEMM_COUNT; i++) {
+      if (dgemms[i])
+        run_load(&options, i);
+    }
+  } else if (options.latency || options.throughput > 0) {
+    if (loop[0] == 0) {
+      run_pinned(&options, length);
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_pinned(&options, length > 0 ? length : i);
+      }
+    }
+  } else if (options.scaling != scaling_none) {
+    for (int i = simple_unroll_blocking_parallel; i < DGEMM_COUNT; i++) {
+      if (!dgemms[i])
+        continue;
+
+      if (loop[0] == 0) {
+        run_scaling(&options, i, length);
+      } else {
+        for (int j = loop[0]; j <= loop[1]; j += loop[2]) {
+          run_scaling(&options, i, length > 0 ? length : j);
+        }
+      }
+    }
+  } else if (options.level2) {
+    double peak = 0;
+    topology topology;
+
+    discover_topology(&options.cpus, &topology);
+    measure_speed(&topology);
+
+    for (int i = 0; i < topology.count; i++)
+      peak += topology.cpus[i].gflops;
+
+    free_topology(&topology);
+
+    if (loop[0] == 0) {
+      run_level2(&options, length, peak);
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_level2(&options, length > 0 ? length : i, peak);
+      }
+    }
+  } else if (options.prepacked > 0) {
+    if (loop[0] == 0) {
+      run_prepacked(&options, length);
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_prepacked(&options, length > 0 ? length : i);
+      }
+    }
+  } else if (options.incremental[0] > 0) {
+    if (loop[0] == 0) {
+      run_incremental(&options, length);
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_incremental(&options, length > 0 ? length : i);
+      }
+    }
+  } else if (density[0] > 0) {
+    if (loop[0] == 0) {
+      run_density_sweep(dgemms, length, &options.generator, density);
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_density_sweep(dgemms, length > 0 ? length : i,
+                          &options.generator, density);
+      }
+    }
+  } else {
+    if (options.energy) {
+      open_energy_meter(&energy_meter);
+      meter = &energy_meter;
+    }
+
+    if (loop[0] == 0) {
+      run_dgemm(dgemms, length, &options.generator, show_result, show_matrices,
+                parallel, epilogue, options.bias, meter);
+    } else if (length > 0) {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_dgemm(dgemms, length, &options.generator, show_result,
+                  show_matrices, parallel, epilogue, options.bias, meter);
+      }
+    } else {
+      for (int i = loop[0]; i <= loop[1]; i += loop[2]) {
+        run_dgemm(dgemms, i, &options.generator, show_result, show_matrices,
+                  parallel, epilogue, options.bias, meter);
+      }
+    }
+
+    if (meter != NULL)
+      close_energy_meter(meter);
+  }
+
+  if (options.trace != NULL && trace_dump(options.trace) != 0)
+    return EXIT_FAILURE;
+
   return 0;
 }
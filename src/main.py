@@ -1,11 +1,22 @@
+import os
 import random
 import sys
 import time
 
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "out"))
 
-def get_matrix_length():
-    arg1 = sys.argv[1]
-    return int(arg1)
+try:
+    import dgemm
+except ImportError:
+    dgemm = None
+
+
+def get_arguments():
+    length = int(sys.argv[1])
+    name = sys.argv[2] if len(sys.argv) > 2 else "python"
+    repeat = int(sys.argv[3]) if len(sys.argv) > 3 else 1
+
+    return length, name, repeat
 
 
 def generate_matrix(length):
@@ -26,15 +37,33 @@ def multiply_matrix(matrix_a, matrix_b, length):
     return matrix_c
 
 
-def main():
-    length = get_matrix_length()
-    matrix_a, matrix_b = generate_matrix(length)
-    init = time.perf_counter()
-    _ = multiply_matrix(matrix_a, matrix_b, length)
-    final = time.perf_counter()
-    diff = final - init
+def benchmark_python(length, repeat):
+    results = []
     gflops = ((2*pow(length, 3))/pow(10, 9))
-    print(f"{length}, {diff*1000:.0f}ms, {gflops/diff:.2f}GFLOPS/second")
+
+    for _ in range(repeat):
+        matrix_a, matrix_b = generate_matrix(length)
+        init = time.perf_counter()
+        _ = multiply_matrix(matrix_a, matrix_b, length)
+        final = time.perf_counter()
+        diff = final - init
+        results.append(("python", length, diff*1000, gflops/diff))
+
+    return results
+
+
+def main():
+    length, name, repeat = get_arguments()
+
+    if name == "python":
+        results = benchmark_python(length, repeat)
+    elif dgemm is None:
+        sys.exit("Error: Módulo dgemm não encontrado, execute 'make python'")
+    else:
+        results = dgemm.benchmark(name, length, repeat)
+
+    for name, length, ms, gflops in results:
+        print(f"{name},{length},{ms:.0f},{gflops:.2f}")
 
 
 if __name__ == "__main__":
@@ -0,0 +1,341 @@
+#include "multiply.h"
+#include "dgemm.h"
+#include "topology.h"
+#include <stdlib.h>
+#include <string.h>
+
+const char *dgemm_names[DGEMM_COUNT] = {
+    "simple",
+    "transpose",
+    "simd_manual",
+    "avx256",
+    "avx512",
+    "simple_unroll",
+    "transpose_unroll",
+    "simd_manual_unroll",
+    "avx256_unroll",
+    "avx512_unroll",
+    "simple_blocking",
+    "transpose_blocking",
+    "simd_manual_blocking",
+    "avx256_blocking",
+    "avx512_blocking",
+    "simple_parallel",
+    "transpose_parallel",
+    "simd_manual_parallel",
+    "avx256_parallel",
+    "avx512_parallel",
+    "perfect",
+    "morton",
+    "pipelined",
+    "balanced",
+#ifdef USE_CBLAS
+    "cblas",
+#endif
+};
+
+void copy_to_big_matrix(int old_length, int new_length, double *old_a,
+                        double *new_a, double *old_b, double *new_b,
+                        double *old_c, double *new_c) {
+
+  int i = 0;
+  for (; i < old_length; i++) {
+    int j = 0;
+    int io = i * old_length;
+    int in = i * new_length;
+    for (; j < old_length; j++) {
+      new_a[j + in] = old_a[j + io];
+      new_b[j + in] = old_b[j + io];
+      new_c[j + in] = old_c[j + io];
+    }
+    for (; j < new_length; j++) {
+      new_a[j + in] = 0;
+      new_b[j + in] = 0;
+      new_c[j + in] = 0;
+    }
+  }
+  for (; i < new_length; i++) {
+    int in = i * new_length;
+    for (int j = 0; j < new_length; j++) {
+      new_a[j + in] = 0;
+      new_b[j + in] = 0;
+      new_c[j + in] = 0;
+    }
+  }
+}
+
+void copy_to_small_matrix(int big_length, int small_length, double *big,
+                          double *small) {
+  for (int i = 0; i < small_length; i++) {
+    int j = 0;
+    int is = i * small_length;
+    int ib = i * big_length;
+    for (; j < small_length; j++) {
+      small[j + is] = big[j + ib];
+    }
+  }
+}
+
+int dgemm_factor(dgemm dgemm) {
+  switch (dgemm) {
+  case avx256:
+  case avx256_unroll:
+    return AVX256_QT_DOUBLE;
+  case avx512:
+  case avx512_unroll:
+    return AVX512_QT_DOUBLE;
+  case simple_unroll_blocking:
+  case transpose_unroll_blocking:
+  case simd_manual_unroll_blocking:
+  case avx256_unroll_blocking:
+  case avx512_unroll_blocking:
+  case simple_unroll_blocking_parallel:
+  case transpose_unroll_blocking_parallel:
+  case simd_manual_unroll_blocking_parallel:
+  case avx256_unroll_blocking_parallel:
+  case avx512_unroll_blocking_parallel:
+  case perfect:
+  case pipelined:
+  case balanced:
+    return BLOCK_SIZE;
+  case morton:
+    return MORTON_TILE;
+  default:
+    return 1;
+  }
+}
+
+bool dgemm_supported(dgemm dgemm) {
+  switch (dgemm) {
+#if !(__AVX__ || __AVX2__)
+  case avx256:
+  case avx256_unroll:
+  case avx256_unroll_blocking:
+  case avx256_unroll_blocking_parallel:
+  case perfect:
+    return false;
+#endif
+#if !__AVX512F__
+  case avx512:
+  case avx512_unroll:
+  case avx512_unroll_blocking:
+  case avx512_unroll_blocking_parallel:
+    return false;
+#endif
+  default:
+    return dgemm >= 0 && dgemm < DGEMM_COUNT;
+  }
+}
+
+void free_scratch(multiply_scratch *scratch) {
+  free(scratch->a);
+  free(scratch->b);
+  free(scratch->c);
+  scratch->length = 0;
+  scratch->a = NULL;
+  scratch->b = NULL;
+  scratch->c = NULL;
+}
+
+void run_kernel(dgemm dgemm, int length, double *a, double *b, double *c) {
+  switch (dgemm) {
+  case DGEMM_COUNT:
+    break;
+  case simple:
+    dgemm_simple(length, a, b, c);
+    break;
+  case transpose:
+    dgemm_transpose(length, a, b, c);
+    break;
+  case simd_manual:
+    dgemm_simd_manual(length, a, b, c);
+    break;
+  case avx256:
+    dgemm_avx256(length, a, b, c);
+    break;
+  case avx512:
+    dgemm_avx512(length, a, b, c);
+    break;
+  case simple_unroll:
+    dgemm_simple_unroll(length, a, b, c);
+    break;
+  case transpose_unroll:
+    dgemm_transpose_unroll(length, a, b, c);
+    break;
+  case simd_manual_unroll:
+    dgemm_simd_manual_unroll(length, a, b, c);
+    break;
+  case avx256_unroll:
+    dgemm_avx256_unroll(length, a, b, c);
+    break;
+  case avx512_unroll:
+    dgemm_avx512_unroll(length, a, b, c);
+    break;
+  case simple_unroll_blocking:
+    dgemm_simple_unroll(length, a, b, c);
+    break;
+  case transpose_unroll_blocking:
+    dgemm_transpose_unroll(length, a, b, c);
+    break;
+  case simd_manual_unroll_blocking:
+    dgemm_simd_manual_unroll_blocking(length, a, b, c);
+    break;
+  case avx256_unroll_blocking:
+    dgemm_avx256_unroll_blocking(length, a, b, c);
+    break;
+  case avx512_unroll_blocking:
+    dgemm_avx512_unroll_blocking(length, a, b, c);
+    break;
+  case simple_unroll_blocking_parallel:
+    dgemm_simple_unroll_blocking_parallel(length, a, b, c);
+    break;
+  case transpose_unroll_blocking_parallel:
+    dgemm_transpose_unroll_blocking_parallel(length, a, b, c);
+    break;
+  case simd_manual_unroll_blocking_parallel:
+    dgemm_simd_manual_unroll_blocking_parallel(length, a, b, c);
+    break;
+  case avx256_unroll_blocking_parallel:
+    dgemm_avx256_unroll_blocking_parallel(length, a, b, c);
+    break;
+  case avx512_unroll_blocking_parallel:
+    dgemm_avx512_unroll_blocking_parallel(length, a, b, c);
+    break;
+  case perfect:
+    dgemm_perfect(length, a, b, c);
+    break;
+  case morton:
+    dgemm_morton(length, a, b, c);
+    break;
+  case pipelined:
+    dgemm_pipelined(length, a, b, c);
+    break;
+  case balanced:
+    dgemm_balanced(length, a, b, c);
+    break;
+#ifdef USE_CBLAS
+  case cblas:
+    dgemm_cblas(length, a, b, c);
+    break;
+#endif
+  }
+}
+
+bool fused_epilogue(dgemm dgemm) {
+  return dgemm == avx256_unroll_blocking ||
+         dgemm == avx256_unroll_blocking_parallel || dgemm == perfect;
+}
+
+void apply_epilogue(int length, double *product, double *c,
+                    dgemm_epilogue *epilogue) {
+  for (int j = 0; j < length; j++) {
+    for (int i = 0; i < length; i++) {
+      double value = epilogue->alpha * product[i + j * length];
+
+      if (epilogue->beta != 0)
+        value += epilogue->beta * c[i + j * length];
+
+      if (epilogue->bias != NULL)
+        value += epilogue->bias[i];
+
+      if (epilogue->activation == activation_relu) {
+        value = value > 0 ? value : 0;
+      } else if (epilogue->activation == activation_clamp) {
+        value = value > epilogue->min ? value : epilogue->min;
+        value = value < epilogue->max ? value : epilogue->max;
+      }
+
+      c[i + j * length] = value;
+    }
+  }
+}
+
+void multiply_with_scratch(dgemm dgemm, int length, double *a, double *b,
+                           double *c, multiply_scratch *scratch,
+                           dgemm_epilogue *epilogue) {
+  int new_length = length;
+  double *new_a, *new_b, *new_c;
+  int factor = dgemm_factor(dgemm);
+  dgemm_epilogue new_epilogue;
+
+  if (length % factor) {
+    new_length += (factor - length % factor);
+
+    if (scratch == NULL) {
+      new_a = aligned_alloc(ALIGN, new_length * new_length * sizeof(double));
+      new_b = aligned_alloc(ALIGN, new_length * new_length * sizeof(double));
+      new_c = aligned_alloc(ALIGN, new_length * new_length * sizeof(double));
+    } else {
+      if (scratch->length < new_length) {
+        free_scratch(scratch);
+        scratch->length = new_length;
+        size_t size = new_length * new_length * sizeof(double);
+        scratch->a = aligned_alloc(ALIGN, size);
+        scratch->b = aligned_alloc(ALIGN, size);
+        scratch->c = aligned_alloc(ALIGN, size);
+      }
+
+      new_a = scratch->a;
+      new_b = scratch->b;
+      new_c = scratch->c;
+    }
+
+    copy_to_big_matrix(length, new_length, a, new_a, b, new_b, c, new_c);
+
+    if (epilogue != NULL && epilogue->bias != NULL) {
+      new_epilogue = *epilogue;
+      new_epilogue.bias = calloc(new_length, sizeof(double));
+      memcpy(new_epilogue.bias, epilogue->bias, length * sizeof(double));
+      epilogue = &new_epilogue;
+    }
+
+  } else {
+    new_a = a;
+    new_b = b;
+    new_c = c;
+  }
+
+  if (epilogue == NULL) {
+    run_kernel(dgemm, new_length, new_a, new_b, new_c);
+  } else if (dgemm == avx256_unroll_blocking) {
+    dgemm_avx256_unroll_blocking_epilogue(new_length, new_a, new_b, new_c,
+                                          epilogue);
+  } else if (dgemm == avx256_unroll_blocking_parallel) {
+    dgemm_avx256_unroll_blocking_parallel_epilogue(new_length, new_a, new_b,
+                                                   new_c, epilogue);
+  } else if (dgemm == perfect) {
+    dgemm_perfect_epilogue(new_length, new_a, new_b, new_c, epilogue);
+  } else {
+    size_t size = new_length * new_length * sizeof(double);
+    double *product = aligned_alloc(ALIGN, size);
+
+    memset(product, 0, size);
+    run_kernel(dgemm, new_length, new_a, new_b, product);
+    apply_epilogue(new_length, product, new_c, epilogue);
+
+    free(product);
+  }
+
+  if (length % factor) {
+    copy_to_small_matrix(new_length, length, new_c, c);
+
+    if (scratch == NULL) {
+      free(new_a);
+      free(new_b);
+      free(new_c);
+    }
+
+    if (epilogue == &new_epilogue)
+      free(new_epilogue.bias);
+  }
+}
+
+void multiply(dgemm dgemm, int length, double *a, double *b, double *c) {
+  multiply_with_scratch(dgemm, length, a, b, c, NULL, NULL);
+}
+
+void multiply_epilogue(dgemm dgemm, int length, double *a, double *b,
+                       double *c, dgemm_epilogue *epilogue) {
+  multiply_with_scratch(dgemm, length, a, b, c, NULL, epilogue);
+}
+
@@ -0,0 +1,58 @@
+#ifndef MULTIPLY_H
+#define MULTIPLY_H
+
+#include "dgemm.h"
+#include <stdbool.h>
+
+typedef enum {
+  simple,
+  transpose,
+  simd_manual,
+  avx256,
+  avx512,
+  simple_unroll,
+  transpose_unroll,
+  simd_manual_unroll,
+  avx256_unroll,
+  avx512_unroll,
+  simple_unroll_blocking,
+  transpose_unroll_blocking,
+  simd_manual_unroll_blocking,
+  avx256_unroll_blocking,
+  avx512_unroll_blocking,
+  simple_unroll_blocking_parallel,
+  transpose_unroll_blocking_parallel,
+  simd_manual_unroll_blocking_parallel,
+  avx256_unroll_blocking_parallel,
+  avx512_unroll_blocking_parallel,
+  perfect,
+  morton,
+  pipelined,
+  balanced,
+#ifdef USE_CBLAS
+  cblas,
+#endif
+  DGEMM_COUNT
+} dgemm;
+
+typedef struct {
+  int length;
+  double *a;
+  double *b;
+  double *c;
+} multiply_scratch;
+
+extern const char *dgemm_names[DGEMM_COUNT];
+
+int dgemm_factor(dgemm dgemm);
+bool fused_epilogue(dgemm dgemm);
+bool dgemm_supported(dgemm dgemm);
+void multiply_with_scratch(dgemm dgemm, int length, double *a, double *b,
+                           double *c, multiply_scratch *scratch,
+                           dgemm_epilogue *epilogue);
+void multiply(dgemm dgemm, int length, double *a, double *b, double *c);
+void multiply_epilogue(dgemm dgemm, int length, double *a, double *b,
+                       double *c, dgemm_epilogue *epilogue);
+void free_scratch(multiply_scratch *scratch);
+
+#endif
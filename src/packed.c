@@ -0,0 +1,94 @@
+#include "packed.h"
+#include "dgemm.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct packed_matrix {
+  int length;
+  int padded;
+  double *blocks;
+  double *a;
+  double *c;
+};
+
+double *packed_block(packed_matrix *packed, int sk, int sj) {
+  int blocks = packed->padded / BLOCK_SIZE;
+  size_t index = (size_t)(sj / BLOCK_SIZE) * blocks + sk / BLOCK_SIZE;
+
+  return packed->blocks + index * BLOCK_SIZE * BLOCK_SIZE;
+}
+
+packed_matrix *pack_matrix(int length, double *b) {
+  packed_matrix *packed = malloc(sizeof(packed_matrix));
+  packed->length = length;
+  packed->padded = (length + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  packed->blocks = aligned_alloc(
+      ALIGN, (size_t)packed->padded * packed->padded * sizeof(double));
+
+#pragma omp parallel for collapse(2)
+  for (int sj = 0; sj < packed->padded; sj += BLOCK_SIZE)
+    for (int sk = 0; sk < packed->padded; sk += BLOCK_SIZE) {
+      double *block = packed_block(packed, sk, sj);
+
+      for (int j = 0; j < BLOCK_SIZE; j++)
+        for (int k = 0; k < BLOCK_SIZE; k++)
+          block[k + j * BLOCK_SIZE] =
+              sk + k < length && sj + j < length
+                  ? b[sk + k + (size_t)(sj + j) * length]
+                  : 0;
+    }
+
+  packed->a = NULL;
+  packed->c = NULL;
+
+  if (packed->padded != length) {
+    size_t size = (size_t)packed->padded * packed->padded * sizeof(double);
+    packed->a = aligned_alloc(ALIGN, size);
+    packed->c = aligned_alloc(ALIGN, size);
+    memset(packed->a, 0, size);
+    memset(packed->c, 0, size);
+  }
+
+  return packed;
+}
+
+void multiply_packed(double *a, packed_matrix *b, double *c) {
+  int length = b->length, padded = b->padded;
+  double *new_a = a, *new_c = c;
+
+  if (padded != length) {
+    new_a = b->a;
+    new_c = b->c;
+
+    for (int j = 0; j < length; j++) {
+      memcpy(new_a + (size_t)j * padded, a + (size_t)j * length,
+             length * sizeof(double));
+      memcpy(new_c + (size_t)j * padded, c + (size_t)j * length,
+             length * sizeof(double));
+    }
+  }
+
+#pragma omp parallel for collapse(2)
+  for (int sj = 0; sj < padded; sj += BLOCK_SIZE)
+    for (int si = 0; si < padded; si += BLOCK_SIZE)
+      for (int sk = 0; sk < padded; sk += BLOCK_SIZE) {
+        TRACE_BEGIN();
+        block_strided(padded, si, sj, new_a + si + (size_t)sk * padded,
+                      padded, packed_block(b, sk, sj), BLOCK_SIZE, new_c);
+        TRACE_END("packed", si, sj, sk);
+      }
+
+  if (padded != length) {
+    for (int j = 0; j < length; j++)
+      memcpy(c + (size_t)j * length, new_c + (size_t)j * padded,
+             length * sizeof(double));
+  }
+}
+
+void free_packed_matrix(packed_matrix *packed) {
+  free(packed->blocks);
+  free(packed->a);
+  free(packed->c);
+  free(packed);
+}
@@ -0,0 +1,10 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+typedef struct packed_matrix packed_matrix;
+
+packed_matrix *pack_matrix(int length, double *b);
+void multiply_packed(double *a, packed_matrix *b, double *c);
+void free_packed_matrix(packed_matrix *packed);
+
+#endif
@@ -0,0 +1,355 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "dgemm.h"
+#include "generator.h"
+#include "multiply.h"
+#include <omp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  PyObject_HEAD int length;
+  double *data;
+  Py_ssize_t shape[2];
+  Py_ssize_t strides[2];
+} aligned_matrix;
+
+int aligned_matrix_getbuffer(PyObject *object, Py_buffer *view, int flags) {
+  aligned_matrix *matrix = (aligned_matrix *)object;
+
+  bool shaped = (flags & PyBUF_ND) == PyBUF_ND;
+
+  if ((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS ||
+      (shaped && (flags & PyBUF_STRIDES) != PyBUF_STRIDES)) {
+    PyErr_SetString(PyExc_BufferError, "matrix is Fortran contiguous");
+    return -1;
+  }
+
+  view->obj = object;
+  view->buf = matrix->data;
+  view->len = (Py_ssize_t)matrix->length * matrix->length * sizeof(double);
+  view->readonly = 0;
+  view->itemsize = sizeof(double);
+  view->format = (flags & PyBUF_FORMAT) ? "d" : NULL;
+  view->ndim = shaped ? 2 : 1;
+  view->shape = shaped ? matrix->shape : NULL;
+  view->strides = shaped ? matrix->strides : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+
+  Py_INCREF(object);
+
+  return 0;
+}
+
+void aligned_matrix_dealloc(PyObject *object) {
+  free(((aligned_matrix *)object)->data);
+  Py_TYPE(object)->tp_free(object);
+}
+
+PyBufferProcs aligned_matrix_buffer = {aligned_matrix_getbuffer, NULL};
+
+PyTypeObject aligned_matrix_type = {
+    PyVarObject_HEAD_INIT(NULL, 0).tp_name = "dgemm.AlignedMatrix",
+    .tp_basicsize = sizeof(aligned_matrix),
+    .tp_dealloc = aligned_matrix_dealloc,
+    .tp_as_buffer = &aligned_matrix_buffer,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Zeroed, ALIGN aligned, column-major square matrix of doubles",
+};
+
+int find_dgemm(const char *name) {
+  for (dgemm dgemm = simple; dgemm < DGEMM_COUNT; dgemm++)
+    if (strcmp(name, dgemm_names[dgemm]) == 0)
+      return dgemm;
+
+  PyErr_Format(PyExc_ValueError, "invalid dgemm '%s'", name);
+  return -1;
+}
+
+PyObject *python_algorithms(PyObject *self, PyObject *args) {
+  (void)self;
+  (void)args;
+
+  PyObject *list = PyList_New(DGEMM_COUNT);
+  if (list == NULL)
+    return NULL;
+
+  for (int i = 0; i < DGEMM_COUNT; i++)
+    PyList_SET_ITEM(list, i, PyUnicode_FromString(dgemm_names[i]));
+
+  return list;
+}
+
+PyObject *python_aligned(PyObject *self, PyObject *args) {
+  (void)self;
+  int length;
+
+  if (!PyArg_ParseTuple(args, "i", &length))
+    return NULL;
+
+  if (length <= 0) {
+    PyErr_SetString(PyExc_ValueError, "length out of range");
+    return NULL;
+  }
+
+  aligned_matrix *matrix = PyObject_New(aligned_matrix, &aligned_matrix_type);
+  if (matrix == NULL)
+    return NULL;
+
+  size_t size = (size_t)length * length * sizeof(double);
+  matrix->length = length;
+  matrix->data = aligned_alloc(ALIGN, (size + ALIGN - 1) / ALIGN * ALIGN);
+  matrix->shape[0] = length;
+  matrix->shape[1] = length;
+  matrix->strides[0] = sizeof(double);
+  matrix->strides[1] = (Py_ssize_t)length * sizeof(double);
+
+  if (matrix->data == NULL) {
+    Py_DECREF(matrix);
+    return PyErr_NoMemory();
+  }
+
+  memset(matrix->data, 0, size);
+
+  return (PyObject *)matrix;
+}
+
+int check_operand(Py_buffer *view, const char *name, int *length,
+                  char *order) {
+  if (view->ndim != 2 || view->shape[0] != view->shape[1] ||
+      view->itemsize != sizeof(double) ||
+      (view->format != NULL && strcmp(view->format, "d") != 0)) {
+    PyErr_Format(PyExc_ValueError, "%s must be a square matrix of doubles",
+                 name);
+    return -1;
+  }
+
+  char current;
+  if (PyBuffer_IsContiguous(view, 'F'))
+    current = 'F';
+  else if (PyBuffer_IsContiguous(view, 'C'))
+    current = 'C';
+  else {
+    PyErr_Format(PyExc_ValueError, "%s must be contiguous", name);
+    return -1;
+  }
+
+  if (*length >= 0 && (*length != view->shape[0] || *order != current)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "a, b and c must have the same shape and order");
+    return -1;
+  }
+
+  if ((uintptr_t)view->buf % ALIGN != 0) {
+    PyErr_Format(PyExc_ValueError, "%s must be aligned to %d bytes", name,
+                 ALIGN);
+    return -1;
+  }
+
+  *length = (int)view->shape[0];
+  *order = current;
+
+  return 0;
+}
+
+bool overlaps(Py_buffer *first, Py_buffer *second) {
+  char *first_start = first->buf, *second_start = second->buf;
+
+  return first_start < second_start + second->len &&
+         second_start < first_start + first->len;
+}
+
+int check_alias(Py_buffer *a, Py_buffer *b, Py_buffer *c) {
+  if (overlaps(c, a) || overlaps(c, b)) {
+    PyErr_SetString(PyExc_ValueError, "c must not overlap a or b");
+    return -1;
+  }
+
+  return 0;
+}
+
+PyObject *python_multiply(PyObject *self, PyObject *args) {
+  (void)self;
+  const char *name;
+  PyObject *objects[3];
+  Py_buffer a, b, c;
+  int length = -1;
+  char order = 0;
+
+  if (!PyArg_ParseTuple(args, "sOOO", &name, &objects[0], &objects[1],
+                        &objects[2]))
+    return NULL;
+
+  if (PyObject_GetBuffer(objects[0], &a, PyBUF_FULL_RO) < 0)
+    return NULL;
+
+  if (PyObject_GetBuffer(objects[1], &b, PyBUF_FULL_RO) < 0) {
+    PyBuffer_Release(&a);
+    return NULL;
+  }
+
+  if (PyObject_GetBuffer(objects[2], &c, PyBUF_FULL) < 0) {
+    PyBuffer_Release(&a);
+    PyBuffer_Release(&b);
+    return NULL;
+  }
+
+  PyObject *result = NULL;
+  int dgemm = find_dgemm(name);
+
+  if (dgemm >= 0 && check_operand(&a, "a", &length, &order) == 0 &&
+      check_operand(&b, "b", &length, &order) == 0 &&
+      check_operand(&c, "c", &length, &order) == 0 &&
+      check_alias(&a, &b, &c) == 0) {
+    double *first = a.buf, *second = b.buf;
+
+    if (order == 'C') {
+      first = b.buf;
+      second = a.buf;
+    }
+
+    double seconds;
+
+    Py_BEGIN_ALLOW_THREADS;
+    double start_time = omp_get_wtime();
+    multiply(dgemm, length, first, second, c.buf);
+    seconds = omp_get_wtime() - start_time;
+    Py_END_ALLOW_THREADS;
+
+    result = PyFloat_FromDouble(seconds);
+  }
+
+  PyBuffer_Release(&a);
+  PyBuffer_Release(&b);
+  PyBuffer_Release(&c);
+
+  return result;
+}
+
+PyObject *python_benchmark(PyObject *self, PyObject *args, PyObject *kwargs) {
+  (void)self;
+  static char *keywords[] = {"dgemm", "length",       "repeat",
+                             "seed",  "distribution", NULL};
+  const char *name, *distribution_name = "uniform";
+  int length, repeat = 1;
+  unsigned long long seed = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "si|iKs", keywords, &name,
+                                   &length, &repeat, &seed,
+                                   &distribution_name))
+    return NULL;
+
+  int dgemm = find_dgemm(name);
+  if (dgemm < 0)
+    return NULL;
+
+  generator generator = {seed, DISTRIBUTION_COUNT};
+  for (int i = 0; i < DISTRIBUTION_COUNT; i++)
+    if (strcmp(distribution_name, distribution_names[i]) == 0)
+      generator.distribution = i;
+
+  if (generator.distribution == DISTRIBUTION_COUNT) {
+    PyErr_Format(PyExc_ValueError, "invalid distribution '%s'",
+                 distribution_name);
+    return NULL;
+  }
+
+  if (length <= 0 || repeat <= 0) {
+    PyErr_SetString(PyExc_ValueError, "length and repeat must be positive");
+    return NULL;
+  }
+
+  size_t size = (size_t)length * length * sizeof(double);
+  size = (size + ALIGN - 1) / ALIGN * ALIGN;
+  double *a = aligned_alloc(ALIGN, size);
+  double *b = aligned_alloc(ALIGN, size);
+  double *c = aligned_alloc(ALIGN, size);
+  double *seconds = malloc(repeat * sizeof(double));
+
+  if (a == NULL || b == NULL || c == NULL || seconds == NULL) {
+    free(a);
+    free(b);
+    free(c);
+    free(seconds);
+    return PyErr_NoMemory();
+  }
+
+  Py_BEGIN_ALLOW_THREADS;
+  generate_matrix(&generator, stream_a, length, length, a);
+  generate_matrix(&generator, stream_b, length, length, b);
+
+  for (int r = 0; r < repeat; r++) {
+    memset(c, 0, (size_t)length * length * sizeof(double));
+
+    double start_time = omp_get_wtime();
+    multiply(dgemm, length, a, b, c);
+    seconds[r] = omp_get_wtime() - start_time;
+  }
+  Py_END_ALLOW_THREADS;
+
+  double gflops = 2.0 * length * length * length / 1e9;
+  PyObject *list = PyList_New(repeat);
+
+  for (int r = 0; list != NULL && r < repeat; r++)
+    PyList_SET_ITEM(list, r,
+                    Py_BuildValue("(sidd)", name, length, seconds[r] * 1000,
+                                  gflops / seconds[r]));
+
+  free(a);
+  free(b);
+  free(c);
+  free(seconds);
+
+  return list;
+}
+
+PyMethodDef python_methods[] = {
+    {"algorithms", python_algorithms, METH_NOARGS,
+     "algorithms() -> list of dgemm names accepted by multiply()"},
+    {"aligned", python_aligned, METH_VARARGS,
+     "aligned(length) -> zeroed AlignedMatrix usable as a, b or c"},
+    {"multiply", python_multiply, METH_VARARGS,
+     "multiply(dgemm, a, b, c) -> seconds\n\n"
+     "Computes c += a @ b in place without copies. a, b and c must be square "
+     "float64 buffers with the same shape, all C or all Fortran contiguous "
+     "and aligned to ALIGN bytes. The GIL is released while the kernel runs."},
+    {"benchmark", (PyCFunction)(void (*)(void))python_benchmark,
+     METH_VARARGS | METH_KEYWORDS,
+     "benchmark(dgemm, length, repeat=1, seed=0, distribution='uniform') -> "
+     "[(name, length, ms, gflops), ...]"},
+    {NULL, NULL, 0, NULL}};
+
+struct PyModuleDef python_module = {PyModuleDef_HEAD_INIT,
+                                    "dgemm",
+                                    "DGEMM kernels",
+                                    -1,
+                                    python_methods,
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    NULL};
+
+PyMODINIT_FUNC PyInit_dgemm(void) {
+  if (PyType_Ready(&aligned_matrix_type) < 0)
+    return NULL;
+
+  PyObject *module = PyModule_Create(&python_module);
+  if (module == NULL)
+    return NULL;
+
+  Py_INCREF(&aligned_matrix_type);
+  if (PyModule_AddObject(module, "AlignedMatrix",
+                         (PyObject *)&aligned_matrix_type) < 0 ||
+      PyModule_AddIntConstant(module, "ALIGN", ALIGN) < 0 ||
+      PyModule_AddIntConstant(module, "BLOCK_SIZE", BLOCK_SIZE) < 0) {
+    Py_DECREF(&aligned_matrix_type);
+    Py_DECREF(module);
+    return NULL;
+  }
+
+  return module;
+}
@@ -0,0 +1,292 @@
+#include "server.h"
+#include "dgemm.h"
+#include "multiply.h"
+#include <errno.h>
+#include <omp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+typedef struct job {
+  server_request request;
+  double *memory;
+  server_response response;
+  bool done;
+  struct job *next;
+} job;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t ready;
+  pthread_cond_t done;
+  job *head;
+  job *tail;
+} job_queue;
+
+job_queue queue = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                   PTHREAD_COND_INITIALIZER, NULL, NULL};
+
+void push_job(job *job) {
+  pthread_mutex_lock(&queue.mutex);
+
+  job->next = NULL;
+  if (queue.tail != NULL)
+    queue.tail->next = job;
+  else
+    queue.head = job;
+  queue.tail = job;
+
+  pthread_cond_signal(&queue.ready);
+
+  while (!job->done)
+    pthread_cond_wait(&queue.done, &queue.mutex);
+
+  pthread_mutex_unlock(&queue.mutex);
+}
+
+int pop_batch(job *batch[SERVER_MAX_BATCH]) {
+  int count = 0;
+
+  pthread_mutex_lock(&queue.mutex);
+
+  while (queue.head == NULL)
+    pthread_cond_wait(&queue.ready, &queue.mutex);
+
+  while (queue.head != NULL && count < SERVER_MAX_BATCH) {
+    batch[count++] = queue.head;
+    queue.head = queue.head->next;
+  }
+
+  if (queue.head == NULL)
+    queue.tail = NULL;
+
+  pthread_mutex_unlock(&queue.mutex);
+
+  return count;
+}
+
+void finish_job(job *job) {
+  pthread_mutex_lock(&queue.mutex);
+  job->done = true;
+  pthread_cond_broadcast(&queue.done);
+  pthread_mutex_unlock(&queue.mutex);
+}
+
+void run_job(job *job, multiply_scratch *scratch) {
+  server_request *request = &job->request;
+  char *memory = (char *)job->memory;
+  double *a = (double *)(memory + request->a);
+  double *b = (double *)(memory + request->b);
+  double *c = (double *)(memory + request->c);
+
+  if (request->clean)
+    memset(c, 0, (size_t)request->length * request->length * sizeof(double));
+
+  double start_time = omp_get_wtime();
+  multiply_with_scratch(request->dgemm, request->length, a, b, c, scratch,
+                        NULL);
+  job->response.seconds = omp_get_wtime() - start_time;
+
+  finish_job(job);
+}
+
+void *execute_jobs(void *arg) {
+  (void)arg;
+
+  job *batch[SERVER_MAX_BATCH];
+  int threads = omp_get_max_threads();
+  multiply_scratch *scratch = calloc(threads, sizeof(multiply_scratch));
+
+  for (;;) {
+    int count = pop_batch(batch);
+
+#pragma omp parallel for schedule(dynamic) if (count > 1)
+    for (int i = 0; i < count; i++)
+      if (batch[i]->request.dgemm < simple_unroll_blocking_parallel)
+        run_job(batch[i], &scratch[omp_get_thread_num()]);
+
+    for (int i = 0; i < count; i++)
+      if (batch[i]->request.dgemm >= simple_unroll_blocking_parallel)
+        run_job(batch[i], &scratch[0]);
+  }
+
+  return NULL;
+}
+
+int validate_request(server_request *request, double *memory, size_t size) {
+  if (memory == NULL)
+    return EBADF;
+
+  if (request->dgemm < 0 || request->dgemm >= DGEMM_COUNT ||
+      request->length <= 0)
+    return EINVAL;
+
+  if ((size_t)request->length > SIZE_MAX / sizeof(double) / request->length)
+    return EINVAL;
+
+  if (!dgemm_supported(request->dgemm))
+    return ENOTSUP;
+
+  size_t matrix_size =
+      (size_t)request->length * request->length * sizeof(double);
+  size_t offsets[3] = {request->a, request->b, request->c};
+
+  for (int i = 0; i < 3; i++) {
+    if (offsets[i] % ALIGN != 0)
+      return EINVAL;
+
+    if (offsets[i] > size || size - offsets[i] < matrix_size)
+      return ERANGE;
+  }
+
+  return 0;
+}
+
+ssize_t receive_request(int client, server_request *request, int *fd) {
+  char control[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {request, sizeof(server_request)};
+  struct msghdr message = {0};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  *fd = -1;
+
+  ssize_t received = recvmsg(client, &message, MSG_WAITALL);
+  if (received != sizeof(server_request))
+    return -1;
+
+  struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+  if (header != NULL && header->cmsg_level == SOL_SOCKET &&
+      header->cmsg_type == SCM_RIGHTS)
+    memcpy(fd, CMSG_DATA(header), sizeof(int));
+
+  return received;
+}
+
+void *serve_connection(void *arg) {
+  int client = (int)(intptr_t)arg;
+  double *memory = NULL;
+  size_t size = 0;
+  server_request request;
+  int fd;
+
+  while (receive_request(client, &request, &fd) > 0) {
+    server_response response = {0, 0};
+
+    if (request.type == request_map) {
+      struct stat info;
+
+      if (memory != NULL)
+        munmap(memory, size);
+
+      memory = NULL;
+      size = 0;
+
+      if (fstat(fd, &info) != 0) {
+        response.status = errno;
+      } else if (request.size > (size_t)info.st_size) {
+        response.status = ERANGE;
+      } else {
+        memory = mmap(NULL, request.size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+
+        if (memory == MAP_FAILED) {
+          response.status = errno;
+          memory = NULL;
+        } else {
+          size = request.size;
+        }
+      }
+
+      if (fd >= 0)
+        close(fd);
+    } else {
+      if (fd >= 0)
+        close(fd);
+
+      response.status = validate_request(&request, memory, size);
+
+      if (response.status == 0) {
+        job job = {request, memory, {0, 0}, false, NULL};
+        push_job(&job);
+        response = job.response;
+      }
+    }
+
+    if (send(client, &response, sizeof(response), MSG_NOSIGNAL) !=
+        sizeof(response))
+      break;
+  }
+
+  if (memory != NULL)
+    munmap(memory, size);
+
+  close(client);
+
+  return NULL;
+}
+
+int run_server(const char *path) {
+  struct sockaddr_un address = {0};
+  address.sun_family = AF_UNIX;
+
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Error: Socket path too long '%s'\n", path);
+    return EXIT_FAILURE;
+  }
+
+  strcpy(address.sun_path, path);
+
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0) {
+    perror("Error: socket");
+    return EXIT_FAILURE;
+  }
+
+  unlink(path);
+
+  if (bind(server, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+      listen(server, SOMAXCONN) < 0) {
+    perror("Error: bind");
+    close(server);
+    return EXIT_FAILURE;
+  }
+
+  pthread_t executor;
+  pthread_create(&executor, NULL, execute_jobs, NULL);
+
+  for (;;) {
+    int client = accept(server, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR)
+        continue;
+
+      perror("Error: accept");
+      break;
+    }
+
+    pthread_t connection;
+    if (pthread_create(&connection, NULL, serve_connection,
+                       (void *)(intptr_t)client) != 0) {
+      close(client);
+      continue;
+    }
+
+    pthread_detach(connection);
+  }
+
+  close(server);
+  unlink(path);
+
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,28 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+
+#define SERVER_MAX_BATCH 64
+
+typedef enum { request_map, request_multiply } request_type;
+
+typedef struct {
+  request_type type;
+  int dgemm;
+  int length;
+  int clean;
+  size_t size;
+  size_t a;
+  size_t b;
+  size_t c;
+} server_request;
+
+typedef struct {
+  int status;
+  double seconds;
+} server_response;
+
+int run_server(const char *path);
+
+#endif
@@ -0,0 +1,130 @@
+#include "sparse.h"
+#include "dgemm.h"
+#include <omp.h>
+#include <stdlib.h>
+#include <x86intrin.h>
+
+csr_matrix *csr_from_dense(int length, double *matrix) {
+  csr_matrix *csr = malloc(sizeof(csr_matrix));
+  csr->length = length;
+  csr->row_start = calloc(length + 1, sizeof(int));
+
+  for (int k = 0; k < length; k++)
+    for (int i = 0; i < length; i++)
+      if (matrix[i + k * length] != 0)
+        csr->row_start[i + 1]++;
+
+  for (int i = 0; i < length; i++)
+    csr->row_start[i + 1] += csr->row_start[i];
+
+  csr->nnz = csr->row_start[length];
+  csr->column = malloc((csr->nnz > 0 ? csr->nnz : 1) * sizeof(int));
+  csr->value = malloc((csr->nnz > 0 ? csr->nnz : 1) * sizeof(double));
+
+  int *next = malloc(length * sizeof(int));
+  for (int i = 0; i < length; i++)
+    next[i] = csr->row_start[i];
+
+  for (int k = 0; k < length; k++) {
+    for (int i = 0; i < length; i++) {
+      if (matrix[i + k * length] != 0) {
+        csr->column[next[i]] = k;
+        csr->value[next[i]] = matrix[i + k * length];
+        next[i]++;
+      }
+    }
+  }
+
+  free(next);
+
+  return csr;
+}
+
+void csr_free(csr_matrix *matrix) {
+  free(matrix->row_start);
+  free(matrix->column);
+  free(matrix->value);
+  free(matrix);
+}
+
+void spmm_row_block(csr_matrix *a, int si, int ei, double *bt, double *tile,
+                    double *c) {
+  int length = a->length;
+
+  for (int i = si; i < ei; i++) {
+    double *row = tile + (i - si) * length;
+
+    for (int j = 0; j < length; j++)
+      row[j] = 0;
+
+    for (int p = a->row_start[i]; p < a->row_start[i + 1]; p++) {
+      double *b_row = bt + a->column[p] * length;
+      int j = 0;
+
+#if __AVX__ || __AVX2__
+      __m256d value = _mm256_broadcast_sd(a->value + p);
+
+      for (; j < length - length % (UNROLL * AVX256_QT_DOUBLE);
+           j += UNROLL * AVX256_QT_DOUBLE) {
+        for (int r = 0; r < UNROLL; r++) {
+          __m256d acc = _mm256_loadu_pd(row + j + r * AVX256_QT_DOUBLE);
+          __m256d column = _mm256_loadu_pd(b_row + j + r * AVX256_QT_DOUBLE);
+          __m256d mul = _mm256_mul_pd(value, column);
+          _mm256_storeu_pd(row + j + r * AVX256_QT_DOUBLE,
+                           _mm256_add_pd(acc, mul));
+        }
+      }
+
+      for (; j < length - length % AVX256_QT_DOUBLE; j += AVX256_QT_DOUBLE) {
+        __m256d acc = _mm256_loadu_pd(row + j);
+        __m256d column = _mm256_loadu_pd(b_row + j);
+        __m256d mul = _mm256_mul_pd(value, column);
+        _mm256_storeu_pd(row + j, _mm256_add_pd(acc, mul));
+      }
+#endif
+
+      for (; j < length; j++)
+        row[j] += a->value[p] * b_row[j];
+    }
+  }
+
+  for (int j = 0; j < length; j++)
+    for (int i = si; i < ei; i++)
+      c[i + j * length] += tile[(i - si) * length + j];
+}
+
+void spmm_csr(csr_matrix *a, double *b, double *c) {
+  int length = a->length;
+  double *bt = aligned_alloc(ALIGN, length * length * sizeof(double));
+  double *tile = aligned_alloc(ALIGN, BLOCK_SIZE * length * sizeof(double));
+  copy_transpose(length, b, bt);
+
+  for (int si = 0; si < length; si += BLOCK_SIZE) {
+    int ei = si + BLOCK_SIZE < length ? si + BLOCK_SIZE : length;
+    spmm_row_block(a, si, ei, bt, tile, c);
+  }
+
+  free(bt);
+  free(tile);
+}
+
+void spmm_csr_parallel(csr_matrix *a, double *b, double *c) {
+  int length = a->length;
+  double *bt = aligned_alloc(ALIGN, length * length * sizeof(double));
+  copy_transpose(length, b, bt);
+
+#pragma omp parallel
+  {
+    double *tile = aligned_alloc(ALIGN, BLOCK_SIZE * length * sizeof(double));
+
+#pragma omp for schedule(dynamic)
+    for (int si = 0; si < length; si += BLOCK_SIZE) {
+      int ei = si + BLOCK_SIZE < length ? si + BLOCK_SIZE : length;
+      spmm_row_block(a, si, ei, bt, tile, c);
+    }
+
+    free(tile);
+  }
+
+  free(bt);
+}
@@ -0,0 +1,17 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+typedef struct {
+  int length;
+  int nnz;
+  int *row_start;
+  int *column;
+  double *value;
+} csr_matrix;
+
+csr_matrix *csr_from_dense(int length, double *matrix);
+void csr_free(csr_matrix *matrix);
+void spmm_csr(csr_matrix *a, double *b, double *c);
+void spmm_csr_parallel(csr_matrix *a, double *b, double *c);
+
+#endif
@@ -0,0 +1,372 @@
+#include "summa.h"
+#include "dgemm.h"
+#include "generator.h"
+#include "level2.h"
+#include <math.h>
+#include <omp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#define SUMMA_SAMPLES 16
+
+typedef struct {
+  int rows;
+  int columns;
+  int row;
+  int column;
+  int length;
+  int padded;
+  int mb;
+  int nb;
+  int width;
+  double *a;
+  double *b;
+  double *c;
+} summa_block;
+
+typedef struct {
+  pthread_barrier_t barrier;
+  double seconds;
+} summa_shared;
+
+double summa_value(generator *generator, generator_stream stream, int length,
+                   int i, int j) {
+  if (i >= length || j >= length)
+    return 0;
+
+  return generator_value(generator, stream, length, length,
+                         i + (long)j * length);
+}
+
+int summa_padded(int rows, int columns, int length) {
+  int a = rows, b = columns;
+
+  while (b != 0) {
+    int remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+
+  int factor = rows / a * columns * BLOCK_SIZE;
+
+  return (length + factor - 1) / factor * factor;
+}
+
+void init_block(summa_block *block, int rows, int columns, int rank,
+                int length, generator *generator) {
+
+  block->rows = rows;
+  block->columns = columns;
+  block->row = rank / columns;
+  block->column = rank % columns;
+  block->length = length;
+  block->padded = summa_padded(rows, columns, length);
+  block->mb = block->padded / rows;
+  block->nb = block->padded / columns;
+  block->width = BLOCK_SIZE;
+
+  size_t size = (size_t)block->mb * block->nb * sizeof(double);
+  block->a = aligned_alloc(ALIGN, size);
+  block->b = aligned_alloc(ALIGN, size);
+  block->c = aligned_alloc(ALIGN, size);
+
+  for (int j = 0; j < block->nb; j++) {
+    for (int i = 0; i < block->mb; i++) {
+      int gi = block->row * block->mb + i, gj = block->column * block->nb + j;
+      block->a[i + j * block->mb] =
+          summa_value(generator, stream_a, length, gi, gj);
+      block->b[i + j * block->mb] =
+          summa_value(generator, stream_b, length, gi, gj);
+      block->c[i + j * block->mb] = 0;
+    }
+  }
+}
+
+void free_block(summa_block *block) {
+  free(block->a);
+  free(block->b);
+  free(block->c);
+}
+
+bool owns_a_panel(summa_block *block, int step) {
+  return block->column == step * block->width / block->nb;
+}
+
+bool owns_b_panel(summa_block *block, int step) {
+  return block->row == step * block->width / block->mb;
+}
+
+void copy_a_panel(summa_block *block, int step, double *panel) {
+  int offset = step * block->width % block->nb;
+  memcpy(panel, block->a + (size_t)offset * block->mb,
+         (size_t)block->mb * block->width * sizeof(double));
+}
+
+void copy_b_panel(summa_block *block, int step, double *panel) {
+  int offset = step * block->width % block->mb;
+
+  for (int j = 0; j < block->nb; j++)
+    for (int k = 0; k < block->width; k++)
+      panel[k + j * block->width] = block->b[offset + k + j * block->mb];
+}
+
+void summa_compute(summa_block *block, double *a_panel, double *b_panel) {
+  dgemm_dispatch(block->mb, block->nb, block->width, a_panel, block->mb,
+                 b_panel, block->width, block->c, block->mb);
+}
+
+double summa_error(summa_block *block, generator *generator) {
+  double error = 0;
+
+  for (int s = 0; s < SUMMA_SAMPLES; s++) {
+    int i = (s * 37) % block->mb, j = (s * 91) % block->nb;
+    int gi = block->row * block->mb + i, gj = block->column * block->nb + j;
+
+    if (gi >= block->length || gj >= block->length)
+      continue;
+
+    double expected = 0;
+    for (int k = 0; k < block->length; k++)
+      expected += summa_value(generator, stream_a, block->length, gi, k) *
+                  summa_value(generator, stream_b, block->length, k, gj);
+
+    double diff = fabs(block->c[i + j * block->mb] - expected) /
+                  (fabs(expected) > 1 ? fabs(expected) : 1);
+    error = diff > error ? diff : error;
+  }
+
+  return error;
+}
+
+void print_summa(int rows, int columns, int length, double seconds,
+                 const char *transport) {
+  double gflops = ((2 * pow(length, 3)) / pow(10, 9));
+  printf("summa,%d,%.0f,%.2f,%dx%d,%s\n", length, seconds * 1000,
+         gflops / seconds, rows, columns, transport);
+}
+
+void summa_shared_rank(summa_shared *shared, double *errors, double *panels,
+                       int rows, int columns, int rank, int length,
+                       generator *generator) {
+  summa_block block;
+  init_block(&block, rows, columns, rank, length, generator);
+
+  int steps = block.padded / block.width;
+  size_t a_size = (size_t)block.mb * block.width;
+  size_t b_size = (size_t)block.width * block.nb;
+  double *a_panels = panels + block.row * 2 * a_size;
+  double *b_panels = panels + rows * 2 * a_size + block.column * 2 * b_size;
+
+  pthread_barrier_wait(&shared->barrier);
+  double start_time = omp_get_wtime();
+
+  for (int step = 0; step <= steps; step++) {
+    if (step < steps) {
+      int slot = step % 2;
+
+      if (owns_a_panel(&block, step))
+        copy_a_panel(&block, step, a_panels + slot * a_size);
+
+      if (owns_b_panel(&block, step))
+        copy_b_panel(&block, step, b_panels + slot * b_size);
+    }
+
+    if (step > 0) {
+      int slot = (step - 1) % 2;
+      summa_compute(&block, a_panels + slot * a_size, b_panels + slot * b_size);
+    }
+
+    pthread_barrier_wait(&shared->barrier);
+  }
+
+  if (rank == 0)
+    shared->seconds = omp_get_wtime() - start_time;
+
+  errors[rank] = summa_error(&block, generator);
+
+  free_block(&block);
+}
+
+int run_summa_shared(int rows, int columns, int length, generator *generator) {
+  int ranks = rows * columns;
+  int padded = summa_padded(rows, columns, length);
+  size_t a_size = (size_t)padded / rows * BLOCK_SIZE;
+  size_t b_size = (size_t)BLOCK_SIZE * (padded / columns);
+  size_t header = sizeof(summa_shared) + ranks * sizeof(double);
+  header = (header + ALIGN - 1) / ALIGN * ALIGN;
+  size_t size = header + (rows * 2 * a_size + columns * 2 * b_size) *
+                             sizeof(double);
+
+  summa_shared *shared = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    perror("Error: mmap");
+    return EXIT_FAILURE;
+  }
+
+  double *errors = (double *)(shared + 1);
+  double *panels = (double *)((char *)shared + header);
+
+  pthread_barrierattr_t attributes;
+  pthread_barrierattr_init(&attributes);
+  pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(&shared->barrier, &attributes, ranks);
+  pthread_barrierattr_destroy(&attributes);
+
+  int threads = omp_get_num_procs() / ranks;
+  omp_set_num_threads(threads > 0 ? threads : 1);
+
+  for (int rank = 1; rank < ranks; rank++) {
+    pid_t pid = fork();
+
+    if (pid == 0) {
+      summa_shared_rank(shared, errors, panels, rows, columns, rank, length,
+                        generator);
+      _exit(EXIT_SUCCESS);
+    }
+
+    if (pid < 0) {
+      perror("Error: fork");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  summa_shared_rank(shared, errors, panels, rows, columns, 0, length,
+                    generator);
+
+  int exit_code = EXIT_SUCCESS;
+  for (int rank = 1; rank < ranks; rank++) {
+    int status;
+    wait(&status);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+      exit_code = EXIT_FAILURE;
+  }
+
+  double error = 0;
+  for (int rank = 0; rank < ranks; rank++)
+    error = errors[rank] > error ? errors[rank] : error;
+
+  print_summa(rows, columns, length, shared->seconds, "shared");
+
+  if (error > 1e-9) {
+    fprintf(stderr, "Error: SUMMA result differs from reference (%g)\n",
+            error);
+    exit_code = EXIT_FAILURE;
+  }
+
+  pthread_barrier_destroy(&shared->barrier);
+  munmap(shared, size);
+
+  return exit_code;
+}
+
+#ifdef USE_MPI
+void start_panels(summa_block *block, int step, double *a_panel,
+                  double *b_panel, MPI_Comm row_comm, MPI_Comm column_comm,
+                  MPI_Request requests[2]) {
+  int width = block->width;
+
+  if (owns_a_panel(block, step))
+    copy_a_panel(block, step, a_panel);
+
+  if (owns_b_panel(block, step))
+    copy_b_panel(block, step, b_panel);
+
+  MPI_Ibcast(a_panel, block->mb * width, MPI_DOUBLE, step * width / block->nb,
+             row_comm, &requests[0]);
+  MPI_Ibcast(b_panel, width * block->nb, MPI_DOUBLE, step * width / block->mb,
+             column_comm, &requests[1]);
+}
+
+int run_summa_mpi(int rows, int columns, int length, generator *generator) {
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  if (size != rows * columns) {
+    if (rank == 0)
+      fprintf(stderr, "Error: Grid %dx%d needs %d ranks, got %d\n", rows,
+              columns, rows * columns, size);
+    return EXIT_FAILURE;
+  }
+
+  summa_block block;
+  init_block(&block, rows, columns, rank, length, generator);
+
+  MPI_Comm row_comm, column_comm;
+  MPI_Comm_split(MPI_COMM_WORLD, block.row, block.column, &row_comm);
+  MPI_Comm_split(MPI_COMM_WORLD, block.column, block.row, &column_comm);
+
+  int steps = block.padded / block.width;
+  size_t a_size = (size_t)block.mb * block.width;
+  size_t b_size = (size_t)block.width * block.nb;
+  double *a_panels = aligned_alloc(ALIGN, 2 * a_size * sizeof(double));
+  double *b_panels = aligned_alloc(ALIGN, 2 * b_size * sizeof(double));
+  MPI_Request requests[2][2];
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  double start_time = MPI_Wtime();
+
+  start_panels(&block, 0, a_panels, b_panels, row_comm, column_comm,
+               requests[0]);
+
+  for (int step = 0; step < steps; step++) {
+    int slot = step % 2, next = (step + 1) % 2;
+
+    if (step + 1 < steps)
+      start_panels(&block, step + 1, a_panels + next * a_size,
+                   b_panels + next * b_size, row_comm, column_comm,
+                   requests[next]);
+
+    MPI_Waitall(2, requests[slot], MPI_STATUSES_IGNORE);
+    summa_compute(&block, a_panels + slot * a_size, b_panels + slot * b_size);
+  }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  double seconds = MPI_Wtime() - start_time;
+
+  double error = summa_error(&block, generator), max_error;
+  MPI_Reduce(&error, &max_error, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+  int exit_code = EXIT_SUCCESS;
+
+  if (rank == 0) {
+    print_summa(rows, columns, length, seconds, "mpi");
+
+    if (max_error > 1e-9) {
+      fprintf(stderr, "Error: SUMMA result differs from reference (%g)\n",
+              max_error);
+      exit_code = EXIT_FAILURE;
+    }
+  }
+
+  MPI_Comm_free(&row_comm);
+  MPI_Comm_free(&column_comm);
+  free(a_panels);
+  free(b_panels);
+  free_block(&block);
+
+  return exit_code;
+}
+#endif
+
+int run_summa(int rows, int columns, int length, generator *generator) {
+#ifdef USE_MPI
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  if (size > 1)
+    return run_summa_mpi(rows, columns, length, generator);
+#endif
+
+  return run_summa_shared(rows, columns, length, generator);
+}
@@ -0,0 +1,8 @@
+#ifndef SUMMA_H
+#define SUMMA_H
+
+#include "generator.h"
+
+int run_summa(int rows, int columns, int length, generator *generator);
+
+#endif
@@ -0,0 +1,269 @@
+#define _GNU_SOURCE
+#include "topology.h"
+#include "dgemm.h"
+#include "trace.h"
+#include <math.h>
+#include <omp.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  int threads;
+  int *cpus;
+  double *weights;
+} placement;
+
+placement balanced = {0, NULL, NULL};
+
+const char *core_type_names[CORE_TYPE_COUNT] = {
+    "unknown",
+    "performance",
+    "efficiency",
+};
+
+int read_int(int cpu, const char *file) {
+  char path[256];
+  int value = -1;
+
+  snprintf(path, sizeof(path), TOPOLOGY_PATH "/cpu%d/%s", cpu, file);
+
+  FILE *stream = fopen(path, "r");
+  if (stream == NULL)
+    return -1;
+
+  if (fscanf(stream, "%d", &value) != 1)
+    value = -1;
+
+  fclose(stream);
+
+  return value;
+}
+
+int read_list(const char *path, cpu_list *list) {
+  char line[4096];
+
+  FILE *stream = fopen(path, "r");
+  if (stream == NULL)
+    return -1;
+
+  char *read = fgets(line, sizeof(line), stream);
+  fclose(stream);
+
+  if (read == NULL)
+    return -1;
+
+  line[strcspn(line, "\n")] = '\0';
+
+  return parse_cpu_list(line, list);
+}
+
+bool list_contains(cpu_list *list, int cpu) {
+  for (int i = 0; i < list->count; i++)
+    if (list->cpus[i] == cpu)
+      return true;
+
+  return false;
+}
+
+void discover_topology(cpu_list *cpus, topology *topology) {
+  cpu_list performance = {0, NULL}, efficiency = {0, NULL};
+  char path[256], file[64];
+
+  read_list("/sys/devices/cpu_core/cpus", &performance);
+  read_list("/sys/devices/cpu_atom/cpus", &efficiency);
+
+  topology->count = cpus->count;
+  topology->cpus = calloc(cpus->count, sizeof(cpu_info));
+
+  for (int i = 0; i < cpus->count; i++) {
+    cpu_info *info = &topology->cpus[i];
+    cpu_list siblings = {0, NULL};
+
+    info->cpu = cpus->cpus[i];
+    info->package = read_int(info->cpu, "topology/physical_package_id");
+    info->core = read_int(info->cpu, "topology/core_id");
+    info->capacity = read_int(info->cpu, "cpu_capacity");
+    info->l2 = info->cpu;
+    info->siblings = 1;
+
+    snprintf(path, sizeof(path),
+             TOPOLOGY_PATH "/cpu%d/topology/thread_siblings_list", info->cpu);
+
+    if (read_list(path, &siblings) == 0) {
+      info->siblings = siblings.count;
+
+      for (int s = 0; s < siblings.count; s++)
+        if (siblings.cpus[s] == info->cpu)
+          info->sibling = s;
+    }
+
+    free_cpu_list(&siblings);
+
+    for (int index = 0;; index++) {
+      snprintf(file, sizeof(file), "cache/index%d/level", index);
+      int level = read_int(info->cpu, file);
+
+      if (level < 0)
+        break;
+
+      if (level != 2)
+        continue;
+
+      cpu_list shared = {0, NULL};
+      snprintf(path, sizeof(path),
+               TOPOLOGY_PATH "/cpu%d/cache/index%d/shared_cpu_list", info->cpu,
+               index);
+
+      if (read_list(path, &shared) == 0)
+        info->l2 = shared.cpus[0];
+
+      free_cpu_list(&shared);
+      break;
+    }
+
+    if (list_contains(&performance, info->cpu))
+      info->type = core_performance;
+    else if (list_contains(&efficiency, info->cpu))
+      info->type = core_efficiency;
+  }
+
+  free_cpu_list(&performance);
+  free_cpu_list(&efficiency);
+}
+
+void physical_cores(topology *topology, cpu_list *cpus) {
+  free_cpu_list(cpus);
+  cpus->cpus = malloc(topology->count * sizeof(int));
+
+  for (int i = 0; i < topology->count; i++) {
+    cpu_info *info = &topology->cpus[i];
+    bool seen = false;
+
+    for (int j = 0; j < i && !seen; j++)
+      seen = topology->cpus[j].package == info->package &&
+             topology->cpus[j].core == info->core && info->core >= 0;
+
+    if (!seen)
+      cpus->cpus[cpus->count++] = info->cpu;
+  }
+}
+
+void measure_speed(topology *topology) {
+  size_t size = BLOCK_SIZE * BLOCK_SIZE * sizeof(double);
+
+#pragma omp parallel num_threads(topology->count)
+  {
+    int id = omp_get_thread_num();
+    cpu_set_t saved;
+    double *a = aligned_alloc(ALIGN, size);
+    double *b = aligned_alloc(ALIGN, size);
+    double *c = aligned_alloc(ALIGN, size);
+
+    for (int i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+      a[i] = 1;
+      b[i] = 1;
+      c[i] = 0;
+    }
+
+    sched_getaffinity(0, sizeof(saved), &saved);
+    pin_thread(topology->cpus[id].cpu);
+    block_strided(BLOCK_SIZE, 0, 0, a, BLOCK_SIZE, b, BLOCK_SIZE, c);
+
+#pragma omp barrier
+    double start_time = omp_get_wtime();
+
+    for (int r = 0; r < TOPOLOGY_BLOCKS; r++)
+      block_strided(BLOCK_SIZE, 0, 0, a, BLOCK_SIZE, b, BLOCK_SIZE, c);
+
+    double seconds = omp_get_wtime() - start_time;
+
+    topology->cpus[id].gflops =
+        2 * pow(BLOCK_SIZE, 3) * TOPOLOGY_BLOCKS / seconds / pow(10, 9);
+    sched_setaffinity(0, sizeof(saved), &saved);
+
+    free(a);
+    free(b);
+    free(c);
+  }
+}
+
+void partition_work(int items, int parts, double *weights, int *bounds) {
+  double total = 0, sum = 0;
+
+  for (int p = 0; p < parts; p++)
+    total += weights != NULL ? weights[p] : 1;
+
+  bool equal = weights == NULL || total <= 0;
+  if (equal)
+    total = parts;
+
+  bounds[0] = 0;
+
+  for (int p = 0; p < parts; p++) {
+    sum += equal ? 1 : weights[p];
+    bounds[p + 1] = (int)llround(items * sum / total);
+  }
+
+  bounds[parts] = items;
+}
+
+void set_placement(topology *topology) {
+  free(balanced.cpus);
+  free(balanced.weights);
+
+  balanced.threads = topology->count;
+  balanced.cpus = malloc(topology->count * sizeof(int));
+  balanced.weights = malloc(topology->count * sizeof(double));
+
+  for (int i = 0; i < topology->count; i++) {
+    balanced.cpus[i] = topology->cpus[i].cpu;
+    balanced.weights[i] = topology->cpus[i].gflops;
+  }
+}
+
+void dgemm_balanced(int length, double *a, double *b, double *c) {
+  int blocks = length / BLOCK_SIZE;
+  int threads = balanced.threads > 0 ? balanced.threads : omp_get_max_threads();
+  int *bounds = malloc((threads + 1) * sizeof(int));
+
+  partition_work(blocks * blocks, threads, balanced.weights, bounds);
+
+#pragma omp parallel num_threads(threads)
+  {
+    cpu_set_t saved;
+    bool placed =
+        balanced.cpus != NULL && omp_get_num_threads() == balanced.threads;
+
+    if (placed) {
+      sched_getaffinity(0, sizeof(saved), &saved);
+      pin_thread(balanced.cpus[omp_get_thread_num()]);
+    }
+
+    for (int part = omp_get_thread_num(); part < threads;
+         part += omp_get_num_threads())
+      for (int tile = bounds[part]; tile < bounds[part + 1]; tile++) {
+        int si = tile % blocks * BLOCK_SIZE, sj = tile / blocks * BLOCK_SIZE;
+
+        for (int sk = 0; sk < length; sk += BLOCK_SIZE) {
+          TRACE_BEGIN();
+          block_strided(length, si, sj, a + si + (size_t)sk * length, length,
+                        b + sk + (size_t)sj * length, length, c);
+          TRACE_END("balanced", si, sj, sk);
+        }
+      }
+
+    if (placed)
+      sched_setaffinity(0, sizeof(saved), &saved);
+  }
+
+  free(bounds);
+}
+
+void free_topology(topology *topology) {
+  free(topology->cpus);
+  topology->cpus = NULL;
+  topology->count = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include "affinity.h"
+
+#define TOPOLOGY_PATH "/sys/devices/system/cpu"
+#define TOPOLOGY_BLOCKS 64
+
+typedef enum {
+  core_unknown,
+  core_performance,
+  core_efficiency,
+  CORE_TYPE_COUNT
+} core_type;
+
+typedef struct {
+  int cpu;
+  int package;
+  int core;
+  int sibling;
+  int siblings;
+  int l2;
+  int capacity;
+  core_type type;
+  double gflops;
+} cpu_info;
+
+typedef struct {
+  int count;
+  cpu_info *cpus;
+} topology;
+
+extern const char *core_type_names[CORE_TYPE_COUNT];
+
+void discover_topology(cpu_list *cpus, topology *topology);
+void physical_cores(topology *topology, cpu_list *cpus);
+void measure_speed(topology *topology);
+void partition_work(int items, int parts, double *weights, int *bounds);
+void set_placement(topology *topology);
+void dgemm_balanced(int length, double *a, double *b, double *c);
+void free_topology(topology *topology);
+
+#endif
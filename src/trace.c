@@ -0,0 +1,134 @@
+#include "trace.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <x86intrin.h>
+
+typedef struct {
+  const char *name;
+  int si;
+  int sj;
+  int sk;
+  uint64_t start;
+  uint64_t end;
+} trace_event;
+
+typedef struct {
+  uint64_t head;
+  trace_event *events;
+} trace_ring;
+
+typedef struct {
+  int threads;
+  uint64_t dropped;
+  double tsc_ghz;
+  trace_ring *rings;
+} trace_state;
+
+trace_state trace = {0, 0, 0, NULL};
+
+void trace_init(int threads) {
+  trace.threads = threads;
+  trace.rings = calloc(threads, sizeof(trace_ring));
+
+  for (int t = 0; t < threads; t++)
+    trace.rings[t].events = calloc(TRACE_CAPACITY, sizeof(trace_event));
+
+  double start_time = omp_get_wtime();
+  uint64_t start_tsc = __rdtsc();
+
+  while (omp_get_wtime() - start_time < 0.01)
+    ;
+
+  trace.tsc_ghz =
+      (__rdtsc() - start_tsc) / (omp_get_wtime() - start_time) / 1e9;
+}
+
+int trace_thread() {
+  for (int level = omp_get_level(); level > 0; level--)
+    if (omp_get_team_size(level) > 1)
+      return omp_get_ancestor_thread_num(level);
+
+  return 0;
+}
+
+void trace_record(const char *name, int si, int sj, int sk, uint64_t start,
+                  uint64_t end) {
+  if (trace.rings == NULL)
+    return;
+
+  int slot = trace_thread();
+
+  if (slot >= trace.threads) {
+#pragma omp atomic
+    trace.dropped++;
+    return;
+  }
+
+  trace_ring *ring = &trace.rings[slot];
+  trace_event *event = &ring->events[ring->head++ % TRACE_CAPACITY];
+
+  event->name = name;
+  event->si = si;
+  event->sj = sj;
+  event->sk = sk;
+  event->start = start;
+  event->end = end;
+}
+
+int trace_dump(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    perror("Error: trace");
+    return -1;
+  }
+
+  uint64_t origin = UINT64_MAX;
+
+  for (int t = 0; t < trace.threads; t++) {
+    trace_ring *ring = &trace.rings[t];
+    uint64_t first = ring->head > TRACE_CAPACITY ? ring->head - TRACE_CAPACITY
+                                                 : 0;
+
+    for (uint64_t e = first; e < ring->head; e++)
+      if (ring->events[e % TRACE_CAPACITY].start < origin)
+        origin = ring->events[e % TRACE_CAPACITY].start;
+  }
+
+  double tsc_mhz = trace.tsc_ghz * 1000;
+  const char *separator = "";
+
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+  for (int t = 0; t < trace.threads; t++) {
+    trace_ring *ring = &trace.rings[t];
+    uint64_t first = ring->head > TRACE_CAPACITY ? ring->head - TRACE_CAPACITY
+                                                 : 0;
+
+    if (first > 0)
+      fprintf(stderr, "Warning: trace thread %d lost %lu events\n", t,
+              (unsigned long)first);
+
+    for (uint64_t e = first; e < ring->head; e++) {
+      trace_event *event = &ring->events[e % TRACE_CAPACITY];
+
+      fprintf(file,
+              "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+              "\"ts\":%.3f,\"dur\":%.3f,"
+              "\"args\":{\"si\":%d,\"sj\":%d,\"sk\":%d}}",
+              separator, event->name, t, (event->start - origin) / tsc_mhz,
+              (event->end - event->start) / tsc_mhz, event->si, event->sj,
+              event->sk);
+      separator = ",";
+    }
+  }
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+
+  if (trace.dropped > 0)
+    fprintf(stderr, "Warning: trace dropped %lu events from extra threads\n",
+            (unsigned long)trace.dropped);
+
+  return 0;
+}
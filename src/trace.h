@@ -0,0 +1,23 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_CAPACITY 16384
+
+#ifdef DGEMM_TRACE
+#include <x86intrin.h>
+#define TRACE_BEGIN() uint64_t trace_start = __rdtsc()
+#define TRACE_END(name, si, sj, sk)                                            \
+  trace_record(name, si, sj, sk, trace_start, __rdtsc())
+#else
+#define TRACE_BEGIN()
+#define TRACE_END(name, si, sj, sk)
+#endif
+
+void trace_init(int threads);
+void trace_record(const char *name, int si, int sj, int sk, uint64_t start,
+                  uint64_t end);
+int trace_dump(const char *path);
+
+#endif